@@ -1,20 +1,22 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "geo.h"
 
 namespace domain {
 
-struct Stop {
-	std::string name;
-	geo::Coordinates coordinates;
-};
+// dense ids in the order stops and buses were added to the catalogue
+using StopId = uint32_t;
+using BusId = uint32_t;
 
 struct Bus {
-	std::string name;
-	std::vector<const Stop*> route;
+	// the route is route_size stop ids starting at route_offset in the route pool of the catalogue
+	uint32_t route_offset = 0;
+	uint32_t route_size = 0;
 	bool ring_route = false;
 };
 
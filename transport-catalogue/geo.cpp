@@ -1,19 +1,76 @@
 #define _USE_MATH_DEFINES
 #include "geo.h"
 
+#include <algorithm>
 #include <cmath>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 namespace geo {
 
+static const double EARTH_RADIUS = 6371000;
+
 double ComputeDistance(Coordinates from, Coordinates to) {
     using namespace std;
     if (from == to) {
         return 0;
     }
     static const double dr = M_PI / 180.;
-    return acos(sin(from.lat * dr) * sin(to.lat * dr)
-        + cos(from.lat * dr) * cos(to.lat * dr) * cos(abs(from.lng - to.lng) * dr))
-        * 6371000;
+    // rounding may push the cosine of a tiny angle above 1
+    return acos(min(1.0, sin(from.lat * dr) * sin(to.lat * dr)
+        + cos(from.lat * dr) * cos(to.lat * dr) * cos(abs(from.lng - to.lng) * dr)))
+        * EARTH_RADIUS;
+}
+
+double ComputeDistance(FixedCoordinates from, FixedCoordinates to) {
+    if (from == to) {
+        return 0;
+    }
+    return ComputeDistance(ToDouble(from), ToDouble(to));
+}
+
+void SpherePoints::Reserve(size_t count) {
+    x_.reserve(count);
+    y_.reserve(count);
+    z_.reserve(count);
+}
+
+void SpherePoints::Add(Coordinates coordinates) {
+    static const double dr = M_PI / 180.;
+    const double lat = coordinates.lat * dr;
+    const double lng = coordinates.lng * dr;
+    x_.push_back(std::cos(lat) * std::cos(lng));
+    y_.push_back(std::cos(lat) * std::sin(lng));
+    z_.push_back(std::sin(lat));
+}
+
+size_t SpherePoints::Size() const {
+    return x_.size();
+}
+
+void SpherePoints::ComputeDistances(const uint32_t* from, const uint32_t* to, size_t count, double* distances) const {
+    size_t i = 0;
+#ifdef __SSE2__
+    // two lanes of chord lengths at a time, asin stays scalar
+    for (; i + 2 <= count; i += 2) {
+        const __m128d dx = _mm_sub_pd(_mm_set_pd(x_[from[i + 1]], x_[from[i]]), _mm_set_pd(x_[to[i + 1]], x_[to[i]]));
+        const __m128d dy = _mm_sub_pd(_mm_set_pd(y_[from[i + 1]], y_[from[i]]), _mm_set_pd(y_[to[i + 1]], y_[to[i]]));
+        const __m128d dz = _mm_sub_pd(_mm_set_pd(z_[from[i + 1]], z_[from[i]]), _mm_set_pd(z_[to[i + 1]], z_[to[i]]));
+        const __m128d chord = _mm_sqrt_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)), _mm_mul_pd(dz, dz)));
+        _mm_storeu_pd(distances + i, chord);
+    }
+#endif
+    for (; i < count; ++i) {
+        const double dx = x_[from[i]] - x_[to[i]];
+        const double dy = y_[from[i]] - y_[to[i]];
+        const double dz = z_[from[i]] - z_[to[i]];
+        distances[i] = std::sqrt(dx * dx + dy * dy + dz * dz);
+    }
+    for (i = 0; i < count; ++i) {
+        distances[i] = 2 * std::asin(std::min(distances[i] / 2, 1.0)) * EARTH_RADIUS;
+    }
 }
 
 }  // namespace geo
\ No newline at end of file
@@ -1,5 +1,10 @@
 #pragma once
 
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
 namespace geo {
 
 struct Coordinates {
@@ -13,6 +18,71 @@ struct Coordinates {
     }
 };
 
+// coordinates in fixed-point micro-degrees, half the size of Coordinates
+struct FixedCoordinates {
+    int32_t lat;
+    int32_t lng;
+    bool operator==(const FixedCoordinates& other) const {
+        return lat == other.lat && lng == other.lng;
+    }
+    bool operator!=(const FixedCoordinates& other) const {
+        return !(*this == other);
+    }
+};
+
+inline constexpr double FIXED_POINT_SCALE = 1e6;
+
+inline FixedCoordinates ToFixed(Coordinates coordinates) {
+    return {
+        static_cast<int32_t>(std::lround(coordinates.lat * FIXED_POINT_SCALE)),
+        static_cast<int32_t>(std::lround(coordinates.lng * FIXED_POINT_SCALE))
+    };
+}
+
+inline Coordinates ToDouble(FixedCoordinates coordinates) {
+    return { coordinates.lat / FIXED_POINT_SCALE, coordinates.lng / FIXED_POINT_SCALE };
+}
+
+inline Coordinates ToDouble(Coordinates coordinates) {
+    return coordinates;
+}
+
+// representation of coordinates kept in the catalogue and the base file
+#ifdef TC_FIXED_POINT_COORDINATES
+using StoredCoordinates = FixedCoordinates;
+
+inline StoredCoordinates ToStored(Coordinates coordinates) {
+    return ToFixed(coordinates);
+}
+#else
+using StoredCoordinates = Coordinates;
+
+inline StoredCoordinates ToStored(Coordinates coordinates) {
+    return coordinates;
+}
+#endif
+
 double ComputeDistance(Coordinates from, Coordinates to);
 
-}  // namespace geo
\ No newline at end of file
+double ComputeDistance(FixedCoordinates from, FixedCoordinates to);
+
+// Points as unit vectors stored by columns. The distance between two points is taken
+// from the chord between their vectors, so a batch needs no trigonometry but asin
+class SpherePoints {
+public:
+    void Reserve(size_t count);
+
+    void Add(Coordinates coordinates);
+
+    size_t Size() const;
+
+    // distances[i] = distance between points from[i] and to[i], i < count
+    void ComputeDistances(const uint32_t* from, const uint32_t* to, size_t count, double* distances) const;
+
+private:
+    std::vector<double> x_;
+    std::vector<double> y_;
+    std::vector<double> z_;
+};
+
+}  // namespace geo
@@ -34,7 +34,9 @@ public:
     IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
 
     std::vector<Edge<Weight>>& GetEdges();
+    const std::vector<Edge<Weight>>& GetEdges() const;
     std::vector<IncidenceList>& GetIncidenceLists();
+    const std::vector<IncidenceList>& GetIncidenceLists() const;
 
 private:
     std::vector<Edge<Weight>> edges_;
@@ -80,10 +82,21 @@ std::vector<Edge<Weight>>& DirectedWeightedGraph<Weight>::GetEdges() {
     return edges_;
 }
 
+template <typename Weight>
+const std::vector<Edge<Weight>>& DirectedWeightedGraph<Weight>::GetEdges() const {
+    return edges_;
+}
+
 template <typename Weight>
 std::vector<typename DirectedWeightedGraph<Weight>::IncidenceList>& 
 DirectedWeightedGraph<Weight>::GetIncidenceLists() {
     return incidence_lists_;
 }
 
+template <typename Weight>
+const std::vector<typename DirectedWeightedGraph<Weight>::IncidenceList>&
+DirectedWeightedGraph<Weight>::GetIncidenceLists() const {
+    return incidence_lists_;
+}
+
 }  // namespace graph
\ No newline at end of file
@@ -1,3 +1,28 @@
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <utility>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include "json.h"
 
 using namespace std;
@@ -186,7 +211,8 @@ Node LoadArray(istream& input) {
 }
 
 Node LoadDict(istream& input) {
-    Dict res;
+    // members are sorted once the object is read
+    std::vector<Dict::value_type> res;
     char c;
     input >> c;
 
@@ -209,7 +235,7 @@ Node LoadDict(istream& input) {
         if (c != ':') {
             throw ParsingError("Failed to parse dict node");
         }
-        res.insert({ move(key), LoadNode(input) });
+        res.emplace_back(move(key), LoadNode(input));
 
         input >> c;
         if (c == '}') {
@@ -221,7 +247,7 @@ Node LoadDict(istream& input) {
     if (c != '}') {
         throw ParsingError("Failed to parse dict node");
     }
-    return Node(move(res));
+    return Node(Dict(move(res)));
 }
 
 Node LoadNode(istream& input) {
@@ -248,6 +274,267 @@ Node LoadNode(istream& input) {
     }
 }
 
+// The same grammar as the stream functions above, with the same errors,
+// but scanning a buffer with a pointer instead of reading characters one by one
+bool IsSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+}
+
+class BufferParser {
+public:
+    // items and members are stacks of elements of containers being read, which are moved
+    // into a container of the exact size once it's read, they may be reused by following parsers
+    BufferParser(const char* begin, const char* end, std::vector<Node>& items, std::vector<Dict::value_type>& members)
+        : pos_(begin)
+        , end_(end)
+        , items_(items)
+        , members_(members) {}
+
+    const char* GetPosition() const {
+        return pos_;
+    }
+
+    Node LoadNode() {
+        char c;
+        if (!NextChar(c)) {
+            throw ParsingError("Failed to parse document"s);
+        }
+
+        if (c == '[') {
+            return LoadArray();
+        } else if (c == '{') {
+            return LoadDict();
+        } else if (c == '"') {
+            return Node(ParseString());
+        } else if (c == 'n') {
+            --pos_;
+            return LoadNull();
+        } else if (std::isdigit(static_cast<unsigned char>(c)) || c == '-') {
+            --pos_;
+            return LoadNum();
+        } else if (c == 't' || c == 'f') {
+            --pos_;
+            return LoadBool();
+        } else {
+            throw ParsingError("Failed to parse document"s);
+        }
+    }
+
+private:
+    const char* pos_;
+    const char* end_;
+    std::vector<Node>& items_;
+    std::vector<Dict::value_type>& members_;
+
+    // the next character after whitespaces, like operator>> of a stream
+    bool NextChar(char& c) {
+        while (pos_ != end_ && IsSpace(*pos_)) {
+            ++pos_;
+        }
+        if (pos_ == end_) {
+            return false;
+        }
+        c = *pos_++;
+        return true;
+    }
+
+    int Peek() const {
+        return pos_ != end_ ? static_cast<unsigned char>(*pos_) : EOF;
+    }
+
+    void SkipDigits() {
+        if (!std::isdigit(Peek())) {
+            throw ParsingError("A digit is expected"s);
+        }
+        while (std::isdigit(Peek())) {
+            ++pos_;
+        }
+    }
+
+    Node LoadNum() {
+        const char* begin = pos_;
+
+        if (Peek() == '-') {
+            ++pos_;
+        }
+        if (Peek() == '0') {
+            ++pos_;
+        } else {
+            SkipDigits();
+        }
+        bool is_int = true;
+        if (Peek() == '.') {
+            ++pos_;
+            SkipDigits();
+            is_int = false;
+        }
+        if (int ch = Peek(); ch == 'e' || ch == 'E') {
+            ++pos_;
+            if (ch = Peek(); ch == '+' || ch == '-') {
+                ++pos_;
+            }
+            SkipDigits();
+            is_int = false;
+        }
+
+        // numbers too big for int become doubles, as with std::stoi() failing
+        if (is_int) {
+            int value;
+            if (const auto [ptr, ec] = std::from_chars(begin, pos_, value); ec == std::errc()) {
+                return Node(value);
+            }
+        }
+        double value;
+        if (const auto [ptr, ec] = std::from_chars(begin, pos_, value); ec != std::errc()) {
+            throw ParsingError("Failed to convert "s + std::string(begin, pos_) + " to number"s);
+        }
+        return Node(value);
+    }
+
+    std::string ParseString() {
+        // the text of the string up to its closing quote is found first, the string is at most as long
+        // and is decoded with a pointer into room made at once
+        const char* close = pos_;
+        while ((close = FindSpecialChar(close, end_)) != end_ && *close == '\\' && end_ - close > 1) {
+            close += 2;
+        }
+        std::string s(static_cast<size_t>(close - pos_), '\0');
+        char* out = s.data();
+
+        while (true) {
+            // plain characters are copied in runs
+            const char* run = pos_;
+            pos_ = FindSpecialChar(pos_, end_);
+            std::memcpy(out, run, static_cast<size_t>(pos_ - run));
+            out += pos_ - run;
+
+            if (pos_ == end_) {
+                throw ParsingError("String parsing error");
+            }
+            const char ch = *pos_++;
+            if (ch == '"') {
+                break;
+            } else if (ch == '\\') {
+                if (pos_ == end_) {
+                    throw ParsingError("String parsing error");
+                }
+                const char escaped_char = *pos_++;
+                switch (escaped_char) {
+                case 'n':
+                    *out++ = '\n';
+                    break;
+                case 't':
+                    *out++ = '\t';
+                    break;
+                case 'r':
+                    *out++ = '\r';
+                    break;
+                case '"':
+                    *out++ = '"';
+                    break;
+                case '\\':
+                    *out++ = '\\';
+                    break;
+                default:
+                    throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
+                }
+            } else {
+                throw ParsingError("Unexpected end of line"s);
+            }
+        }
+        s.resize(static_cast<size_t>(out - s.data()));
+        return s;
+    }
+
+    // the next length characters, fewer at the end of the input
+    std::string_view Take(size_t length) {
+        length = std::min(length, static_cast<size_t>(end_ - pos_));
+        std::string_view res(pos_, length);
+        pos_ += length;
+        return res;
+    }
+
+    Node LoadNull() {
+        if (Take(4) != "null"sv) {
+            throw ParsingError("Failed to parse null node");
+        }
+        return Node();
+    }
+
+    Node LoadBool() {
+        const std::string_view res = Take(*pos_ == 't' ? 4 : 5);
+        if (res == "true"sv) {
+            return Node(true);
+        } else if (res == "false"sv) {
+            return Node(false);
+        }
+        throw ParsingError("Failed to parse bool node");
+    }
+
+    Node LoadArray() {
+        const size_t first = items_.size();
+        char c = 0;
+        while (NextChar(c)) {
+            if (c == ']') {
+                break;
+            }
+            if (c != ',') {
+                --pos_;
+            }
+            // the item is read before it's pushed, since it may use the stack itself
+            Node item = LoadNode();
+            items_.push_back(move(item));
+        }
+        if (c != ']') {
+            throw ParsingError("Failed to parse array node");
+        }
+        Array res(make_move_iterator(items_.begin() + first), make_move_iterator(items_.end()));
+        items_.resize(first);
+        return Node(move(res));
+    }
+
+    Node LoadDict() {
+        const size_t first = members_.size();
+        char c = 0;
+        if (!NextChar(c)) {
+            throw ParsingError("Failed to parse dict node");
+        }
+
+        if (c == '}') {
+            return Node(Dict{});
+        } else {
+            --pos_;
+        }
+        while (NextChar(c)) {
+            --pos_;
+            auto first_node = LoadNode();
+            if (!first_node.IsString()) {
+                throw ParsingError("Failed to parse dict key");
+            }
+
+            if (!NextChar(c) || c != ':') {
+                throw ParsingError("Failed to parse dict node");
+            }
+            auto& key = std::get<std::string>(first_node.GetValue());
+            Node value = LoadNode();
+            members_.emplace_back(move(key), move(value));
+
+            // at the end of the input c is still ':', as with a failed stream read
+            if (NextChar(c) && c == '}') {
+                break;
+            } else if (c != ',') {
+                throw ParsingError("Failed to parse dict");
+            }
+        }
+        if (c != '}') {
+            throw ParsingError("Failed to parse dict node");
+        }
+        std::vector<Dict::value_type> res(make_move_iterator(members_.begin() + first), make_move_iterator(members_.end()));
+        members_.resize(first);
+        return Node(Dict(move(res)));
+    }
+};
+
 }  // namespace
 
 //------------- Node -------------------------
@@ -350,31 +637,263 @@ Document Load(istream& input) {
     return Document{ LoadNode(input) };
 }
 
-//--------------------- Print ------------------------------
-std::string AddEscapes(const std::string& s) {
-    std::string res;
-    for (auto c : s) {
-        switch (c) {
-        case '\"':
-            res += "\\\"";
+//------------- StreamReader -------------------------
+
+StreamReader::StreamReader(std::string_view input)
+    : pos_(input.data())
+    , end_(input.data() + input.size()) {
+}
+
+int StreamReader::PeekChar() {
+    while (pos_ != end_ && IsSpace(*pos_)) {
+        ++pos_;
+    }
+    return pos_ != end_ ? static_cast<unsigned char>(*pos_) : EOF;
+}
+
+bool StreamReader::StartObject() {
+    if (PeekChar() == '{') {
+        ++pos_;
+        return true;
+    }
+    return false;
+}
+
+bool StreamReader::StartArray() {
+    if (PeekChar() == '[') {
+        ++pos_;
+        return true;
+    }
+    return false;
+}
+
+std::optional<std::string> StreamReader::NextKey() {
+    if (PeekChar() == ',') {
+        ++pos_;
+    }
+    const int c = PeekChar();
+    if (c == '}') {
+        ++pos_;
+        return std::nullopt;
+    }
+    if (c != '"') {
+        throw ParsingError(c == EOF ? "Failed to parse dict node"s : "Failed to parse dict key"s);
+    }
+
+    Node key = LoadNode();
+    if (PeekChar() != ':') {
+        throw ParsingError("Failed to parse dict node");
+    }
+    ++pos_;
+    return std::move(std::get<std::string>(key.GetValue()));
+}
+
+bool StreamReader::NextItem() {
+    if (PeekChar() == ',') {
+        ++pos_;
+    }
+    const int c = PeekChar();
+    if (c == EOF) {
+        throw ParsingError("Failed to parse array node");
+    }
+    if (c == ']') {
+        ++pos_;
+        return false;
+    }
+    return true;
+}
+
+Node StreamReader::LoadNode() {
+    BufferParser parser(pos_, end_, items_, members_);
+    Node res = parser.LoadNode();
+    pos_ = parser.GetPosition();
+    return res;
+}
+
+void StreamReader::SkipValue() {
+    if (StartObject()) {
+        while (NextKey()) {
+            SkipValue();
+        }
+    } else if (StartArray()) {
+        while (NextItem()) {
+            SkipValue();
+        }
+    } else {
+        LoadNode();
+    }
+}
+
+//------------- InputBuffer -------------------------
+
+InputBuffer InputBuffer::FromStdin() {
+#if defined(__unix__) || defined(__APPLE__)
+    return FromDescriptor(STDIN_FILENO);
+#else
+    InputBuffer res;
+    res.data_.assign(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+    return res;
+#endif
+}
+
+InputBuffer InputBuffer::FromDescriptor([[maybe_unused]] int fd) {
+    InputBuffer res;
+#if defined(__unix__) || defined(__APPLE__)
+    struct stat info;
+    if (::fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        const size_t size = static_cast<size_t>(info.st_size);
+        void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            ::madvise(mapping, size, MADV_SEQUENTIAL);
+            res.mapping_ = mapping;
+            res.mapping_size_ = size;
+            return res;
+        }
+    }
+
+    // not a regular file or it can't be mapped
+    char chunk[64 * 1024];
+    ssize_t count;
+    while ((count = ::read(fd, chunk, sizeof(chunk))) > 0) {
+        res.data_.append(chunk, static_cast<size_t>(count));
+    }
+#endif
+    return res;
+}
+
+InputBuffer::InputBuffer(InputBuffer&& other) noexcept
+    : data_(move(other.data_))
+    , mapping_(std::exchange(other.mapping_, nullptr))
+    , mapping_size_(std::exchange(other.mapping_size_, 0)) {
+}
+
+InputBuffer& InputBuffer::operator=(InputBuffer&& other) noexcept {
+    // the old contents of this buffer are freed with other
+    std::swap(data_, other.data_);
+    std::swap(mapping_, other.mapping_);
+    std::swap(mapping_size_, other.mapping_size_);
+    return *this;
+}
+
+InputBuffer::~InputBuffer() {
+#if defined(__unix__) || defined(__APPLE__)
+    if (mapping_) {
+        ::munmap(mapping_, mapping_size_);
+    }
+#endif
+}
+
+std::string_view InputBuffer::GetView() const {
+    if (mapping_) {
+        return { static_cast<const char*>(mapping_), mapping_size_ };
+    }
+    return data_;
+}
+
+//--------------------- Strings ------------------------------
+
+namespace {
+
+// position of the lowest set bit, the mask mustn't be zero
+[[maybe_unused]] unsigned CountTrailingZeros(unsigned mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+} // namespace
+
+const char* FindSpecialChar(const char* begin, const char* end) {
+#if defined(__AVX2__)
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i line_feed = _mm256_set1_epi8('\n');
+    const __m256i carriage_return = _mm256_set1_epi8('\r');
+    for (; end - begin >= 32; begin += 32) {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+        const __m256i found = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, quote), _mm256_cmpeq_epi8(block, backslash)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, line_feed), _mm256_cmpeq_epi8(block, carriage_return)));
+        if (const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(found))) {
+            return begin + CountTrailingZeros(mask);
+        }
+    }
+#elif defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i line_feed = _mm_set1_epi8('\n');
+    const __m128i carriage_return = _mm_set1_epi8('\r');
+    for (; end - begin >= 16; begin += 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+        const __m128i found = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, backslash)),
+            _mm_or_si128(_mm_cmpeq_epi8(block, line_feed), _mm_cmpeq_epi8(block, carriage_return)));
+        if (const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(found))) {
+            return begin + CountTrailingZeros(mask);
+        }
+    }
+#endif
+    // the tail shorter than a block
+    while (begin != end && *begin != '"' && *begin != '\\' && *begin != '\n' && *begin != '\r') {
+        ++begin;
+    }
+    return begin;
+}
+
+void WriteEscaped(std::string_view str, std::string& output) {
+    // the string is written with a pointer into room made beforehand and cut afterwards,
+    // some room for escapes is made at once, the rest only when needed, up to twice the string
+    const char* pos = str.data();
+    const char* end = str.data() + str.size();
+    const size_t start = output.size();
+    output.resize(start + str.size() + str.size() / 8 + 2);
+    char* out = output.data() + start;
+    bool grown = false;
+    *out++ = '"';
+
+    while (true) {
+        // plain characters are copied in runs
+        const char* run = pos;
+        pos = FindSpecialChar(pos, end);
+        if (!grown && static_cast<size_t>(output.data() + output.size() - out) < static_cast<size_t>(pos - run) + 3) {
+            const size_t written = static_cast<size_t>(out - output.data());
+            output.resize(written + 2 * static_cast<size_t>(end - run) + 1);
+            out = output.data() + written;
+            grown = true;
+        }
+        std::memcpy(out, run, static_cast<size_t>(pos - run));
+        out += pos - run;
+        if (pos == end) {
+            break;
+        }
+
+        *out++ = '\\';
+        switch (*pos++) {
+        case '"':
+            *out++ = '"';
             break;
         case '\r':
-            res += "\\r";
+            *out++ = 'r';
             break;
         case '\n':
-            res += "\\n";
-            break;
-        case '\\':
-            res += "\\\\";
+            *out++ = 'n';
             break;
         default:
-            res += c;
+            *out++ = '\\';
             break;
         }
     }
-    return res;
+
+    *out++ = '"';
+    output.resize(static_cast<size_t>(out - output.data()));
 }
 
+//--------------------- Print ------------------------------
+
 void PrintNode(const Node& node, const PrintContext& ctx);
 
 template <typename Value>
@@ -427,8 +946,10 @@ void PrintValue(const Dict& value, const PrintContext& ctx) {
     ctx.PrintIndent();
     ctx.out << "}"sv;
 }
-void PrintValue(const std::string value, const PrintContext& ctx) {
-    ctx.out << "\""sv << AddEscapes(value) << "\""sv;
+void PrintValue(const std::string& value, const PrintContext& ctx) {
+    std::string escaped;
+    WriteEscaped(value, escaped);
+    ctx.out << escaped;
 }
 
 void PrintNode(const Node& node, const PrintContext& ctx) {
@@ -1,17 +1,70 @@
 #pragma once
 
+#include <algorithm>
+#include <initializer_list>
 #include <iostream>
-#include <map>
+#include <optional>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <variant>
 
 namespace json {
 
 class Node;
-using Dict = std::map<std::string, Node>;
 using Array = std::vector<Node>;
 
+// Members of an object in one array sorted by key, much more compact than a tree
+// and faster to build. Keys are looked up with binary search, the first of repeated keys is kept
+class Dict final {
+public:
+    using value_type = std::pair<std::string, Node>;
+    using iterator = std::vector<value_type>::iterator;
+    using const_iterator = std::vector<value_type>::const_iterator;
+
+    Dict() = default;
+    Dict(std::initializer_list<value_type> members);
+    // members in any order, sorted once
+    explicit Dict(std::vector<value_type> members);
+
+    const Node& at(std::string_view key) const;
+    Node& operator[](const std::string& key);
+    size_t count(std::string_view key) const;
+    const_iterator find(std::string_view key) const;
+
+    std::pair<iterator, bool> insert(value_type member);
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(Args&&... args);
+
+    const_iterator begin() const {
+        return members_.begin();
+    }
+    const_iterator end() const {
+        return members_.end();
+    }
+    size_t size() const {
+        return members_.size();
+    }
+    bool empty() const {
+        return members_.empty();
+    }
+    size_t capacity() const {
+        return members_.capacity();
+    }
+
+    bool operator==(const Dict& other) const;
+    bool operator!=(const Dict& other) const {
+        return !(*this == other);
+    }
+
+private:
+    std::vector<value_type> members_;
+
+    iterator LowerBound(std::string_view key);
+    const_iterator LowerBound(std::string_view key) const;
+};
+
 class ParsingError : public std::runtime_error {
 public:
     using runtime_error::runtime_error;
@@ -49,6 +102,80 @@ public:
     Value& GetValue();
 };
 
+//------------- Dict -------------------------
+
+inline Dict::Dict(std::initializer_list<value_type> members)
+    : Dict(std::vector<value_type>(members)) {
+}
+
+inline Dict::Dict(std::vector<value_type> members)
+    : members_(std::move(members)) {
+    const auto less = [](const value_type& lhs, const value_type& rhs) {
+        return lhs.first < rhs.first;
+    };
+    // objects are mostly small, insertion sort keeps them stable without a temporary buffer
+    if (members_.size() <= 16) {
+        for (auto it = members_.begin(); it != members_.end(); ++it) {
+            std::rotate(std::upper_bound(members_.begin(), it, *it, less), it, it + 1);
+        }
+    } else {
+        std::stable_sort(members_.begin(), members_.end(), less);
+    }
+    members_.erase(std::unique(members_.begin(), members_.end(), [](const value_type& lhs, const value_type& rhs) {
+        return lhs.first == rhs.first;
+    }), members_.end());
+}
+
+inline Dict::iterator Dict::LowerBound(std::string_view key) {
+    return std::lower_bound(members_.begin(), members_.end(), key, [](const value_type& member, std::string_view key) {
+        return member.first < key;
+    });
+}
+
+inline Dict::const_iterator Dict::LowerBound(std::string_view key) const {
+    return std::lower_bound(members_.begin(), members_.end(), key, [](const value_type& member, std::string_view key) {
+        return member.first < key;
+    });
+}
+
+inline const Node& Dict::at(std::string_view key) const {
+    const auto it = find(key);
+    if (it == members_.end()) {
+        throw std::out_of_range("No key " + std::string(key));
+    }
+    return it->second;
+}
+
+inline Node& Dict::operator[](const std::string& key) {
+    return emplace(key, Node{}).first->second;
+}
+
+inline size_t Dict::count(std::string_view key) const {
+    return find(key) != members_.end() ? 1 : 0;
+}
+
+inline Dict::const_iterator Dict::find(std::string_view key) const {
+    const auto it = LowerBound(key);
+    return it != members_.end() && it->first == key ? it : members_.end();
+}
+
+inline std::pair<Dict::iterator, bool> Dict::insert(value_type member) {
+    const auto it = LowerBound(member.first);
+    if (it != members_.end() && it->first == member.first) {
+        return { it, false };
+    }
+    return { members_.insert(it, std::move(member)), true };
+}
+
+template <typename... Args>
+std::pair<Dict::iterator, bool> Dict::emplace(Args&&... args) {
+    return insert(value_type(std::forward<Args>(args)...));
+}
+
+inline bool Dict::operator==(const Dict& other) const {
+    return members_ == other.members_;
+}
+
 class Document final {
 public:
     Document(Node root);
@@ -85,6 +212,69 @@ struct PrintContext {
     }
 };
 
+// The whole input in one contiguous block of memory: a regular file is mapped,
+// anything else (pipes, terminals) is read up to its end
+class InputBuffer final {
+public:
+    static InputBuffer FromStdin();
+
+    InputBuffer(InputBuffer&& other) noexcept;
+    InputBuffer& operator=(InputBuffer&& other) noexcept;
+    ~InputBuffer();
+
+    std::string_view GetView() const;
+
+private:
+    InputBuffer() = default;
+
+    static InputBuffer FromDescriptor(int fd);
+
+    std::string data_;
+    void* mapping_ = nullptr;
+    size_t mapping_size_ = 0;
+};
+
+// Reads a document from memory piece by piece, so big arrays can be handled item by item
+// without building them whole. Errors are reported with ParsingError, as by Load()
+class StreamReader final {
+public:
+    explicit StreamReader(std::string_view input);
+
+    // enter the next value if it's an object or an array, any other value is left unread
+    bool StartObject();
+    bool StartArray();
+
+    // key of the next member of the object entered last, nullopt once the object is over
+    std::optional<std::string> NextKey();
+
+    // whether the array entered last has one more item, false once the array is over
+    bool NextItem();
+
+    // reads the next value whole
+    Node LoadNode();
+
+    // passes the next value without building it
+    void SkipValue();
+
+private:
+    const char* pos_;
+    const char* end_;
+    // elements of containers being read, kept between calls to LoadNode() to save allocations
+    std::vector<Node> items_;
+    std::vector<Dict::value_type> members_;
+
+    // the next character after whitespaces, EOF at the end of the input
+    int PeekChar();
+};
+
+// the first character of [begin, end) which is escaped in strings: '"', '\\', '\n' or '\r',
+// end if there is none. Blocks of 16 or 32 characters are checked at once where SSE2 or AVX2 is on
+const char* FindSpecialChar(const char* begin, const char* end);
+
+// appends str to output in quotes, with the escapes Print() makes
+void WriteEscaped(std::string_view str, std::string& output);
+
+// reads one document, the rest of the input is left unread
 Document Load(std::istream& input);
 
 void Print(const Document& doc, std::ostream& output);
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <limits>
 #include <string>
 #include <vector>
 #include <sstream>
@@ -8,32 +10,133 @@ using namespace std::literals;
 
 namespace json_reader {
 
+namespace {
+
+// heap memory owned by the node, the node itself is counted by its container
+size_t GetNodeBytes(const json::Node& node) {
+	using namespace memory_usage;
+
+	if (node.IsString()) {
+		return GetStringBytes(node.AsString());
+	}
+	if (node.IsArray()) {
+		size_t res = GetVectorBytes(node.AsArray());
+		for (const auto& item : node.AsArray()) {
+			res += GetNodeBytes(item);
+		}
+		return res;
+	}
+	if (node.IsMap()) {
+		size_t res = node.AsMap().capacity() * sizeof(json::Dict::value_type);
+		for (const auto& [key, value] : node.AsMap()) {
+			res += GetStringBytes(key) + GetNodeBytes(value);
+		}
+		return res;
+	}
+	return 0;
+}
+
+} // namespace
+
 JSONReader::JSONReader(std::istream& input) : document_(json::Load(input)) {}
 
-bool JSONReader::LoadDataToTransportCatalogue(transport_catalogue::TransportCatalogue& catalogue) const {
-	if (document_.GetRoot().IsMap() && document_.GetRoot().AsMap().count("base_requests"s)) {
-		const auto& data = document_.GetRoot().AsMap().at("base_requests"s);
-		if (data.IsArray()) {
-			LoadStops(catalogue, data.AsArray());
-			LoadBuses(catalogue, data.AsArray());
+JSONReader::JSONReader(std::string_view input, transport_catalogue::TransportCatalogue& catalogue)
+	: document_(LoadMembers(input, [&catalogue](const std::string& key, json::StreamReader& reader) {
+		if (key == "base_requests"s && reader.StartArray()) {
+			LoadBaseRequests(reader, catalogue);
+			return true;
+		}
+		return false;
+	})) {}
+
+JSONReader::JSONReader() : document_(json::Node{}) {}
 
+JSONReader JSONReader::LoadWithoutStatRequests(std::string_view input) {
+	JSONReader res;
+	res.document_ = json::Document(LoadMembers(input, [](const std::string& key, json::StreamReader& reader) {
+		if (key == "stat_requests"s) {
+			reader.SkipValue();
 			return true;
 		}
+		return false;
+	}));
+	return res;
+}
+
+json::Node JSONReader::LoadMembers(std::string_view input,
+	const std::function<bool(const std::string&, json::StreamReader&)>& take) {
+	json::StreamReader reader(input);
+	if (!reader.StartObject()) {
+		return reader.LoadNode();
 	}
-	return false;
+
+	json::Dict root;
+	while (auto key = reader.NextKey()) {
+		if (!take(*key, reader)) {
+			root.emplace(std::move(*key), reader.LoadNode());
+		}
+	}
+	return root;
+}
+
+memory_usage::Report JSONReader::GetMemoryUsage() const {
+	return { { "document"s, sizeof(json::Node) + GetNodeBytes(document_.GetRoot()) } };
 }
 
-void JSONReader::PrintResponses(const request_handler::RequestHandler& handler, std::ostream& output) const {
+void JSONReader::PrintResponses(const request_handler::RequestHandler& handler, std::ostream& output,
+	bool compact) const {
 	if (document_.GetRoot().IsMap() && document_.GetRoot().AsMap().count("stat_requests"s)) {
 		const auto& data = document_.GetRoot().AsMap().at("stat_requests"s);
 		if (data.IsArray()) {
-			const auto responses = GetResponses(handler, data.AsArray());
+			std::string buffer;
+			json::Writer writer(buffer, compact);
+			request_handler::RequestHandler::Route route;
 
-			json::Print(responses, output);
+			writer.StartArray();
+			for (const auto& request : data.AsArray()) {
+				WriteResponse(handler, request, route, writer);
+			}
+			writer.EndArray();
+
+			output << buffer;
 		}
 	}
 }
 
+void JSONReader::PrintResponses(const request_handler::RequestHandler& handler, std::string_view input,
+	std::ostream& output, bool compact) const {
+	json::StreamReader reader(input);
+	if (!reader.StartObject()) {
+		return;
+	}
+
+	while (auto key = reader.NextKey()) {
+		if (*key != "stat_requests"s || !reader.StartArray()) {
+			reader.SkipValue();
+			continue;
+		}
+
+		// the buffer is sent after every response and reused
+		std::string buffer;
+		json::Writer writer(buffer, compact);
+		request_handler::RequestHandler::Route route;
+
+		writer.StartArray();
+		while (reader.NextItem()) {
+			if (WriteResponse(handler, reader.LoadNode(), route, writer)) {
+				output << buffer;
+				output.flush();
+				buffer.clear();
+			}
+		}
+		writer.EndArray();
+
+		output << buffer;
+		// the first array is printed only, as with a document, where the first of repeated keys is kept
+		return;
+	}
+}
+
 std::optional<map_renderer::RenderSettings> JSONReader::GetRenderSettings() const {
 	if (document_.GetRoot().IsMap() && document_.GetRoot().AsMap().count("render_settings"s)) {
 		const auto& data = document_.GetRoot().AsMap().at("render_settings"s);
@@ -68,38 +171,72 @@ std::optional<serializer::SerializerSettings> JSONReader::GetSerializerSettings(
 	return std::nullopt;
 }
 
-void JSONReader::LoadStops(transport_catalogue::TransportCatalogue& catalogue, const json::Array& data) const {
-	for (const auto& item : data) {
-		if (IsStop(item)) {
-			catalogue.AddStop(item.AsMap().at("name"s).AsString(),
-				{ item.AsMap().at("latitude"s).AsDouble(), item.AsMap().at("longitude"s).AsDouble() });
-		}
-	}
-	for (const auto& item : data) {
+void JSONReader::LoadBaseRequests(json::StreamReader& reader, transport_catalogue::TransportCatalogue& catalogue) {
+	// whatever refers to stops not read yet waits till the end of the requests,
+	// buses keep their order, so their ids don't depend on where stops are placed
+	std::vector<PendingDistance> pending_distances;
+	std::vector<PendingBus> pending_buses;
+	std::vector<domain::StopId> route;
+
+	while (reader.NextItem()) {
+		const json::Node item = reader.LoadNode();
+
 		if (IsStop(item)) {
-			const auto& distances = item.AsMap().at("road_distances"s).AsMap();
-			const auto& from = item.AsMap().at("name"s).AsString();
-			for (const auto& [to, distance] : distances) {
-				if (distance.IsInt()) {
-					catalogue.SetDistance(from, to, distance.AsInt());
+			const auto& stop = item.AsMap();
+			const domain::StopId from = catalogue.AddStop(stop.at("name"s).AsString(),
+				{ stop.at("latitude"s).AsDouble(), stop.at("longitude"s).AsDouble() });
+
+			for (const auto& [to, distance] : stop.at("road_distances"s).AsMap()) {
+				if (!distance.IsInt()) {
+					continue;
+				}
+				if (const auto to_id = catalogue.FindStopId(to)) {
+					catalogue.SetDistance(from, *to_id, distance.AsInt());
+				} else {
+					pending_distances.push_back({ from, to, distance.AsInt() });
+				}
+			}
+		} else if (IsBus(item)) {
+			const auto& bus = item.AsMap();
+			const auto& name = bus.at("name"s).AsString();
+			const bool ring_route = bus.at("is_roundtrip"s).AsBool();
+
+			bool ready = pending_buses.empty();
+			route.clear();
+			for (const auto& stop : bus.at("stops"s).AsArray()) {
+				if (!ready || !stop.IsString()) {
+					continue;
+				}
+				if (const auto id = catalogue.FindStopId(stop.AsString())) {
+					route.push_back(*id);
+				} else {
+					ready = false;
 				}
 			}
-		}
-	}
-}
 
-void JSONReader::LoadBuses(transport_catalogue::TransportCatalogue& catalogue, const json::Array& data) const {
-	for (const auto& item : data) {
-		if (IsBus(item)) {
-			std::vector<std::string> stops;
-			for (const auto& stop : item.AsMap().at("stops"s).AsArray()) {
-				if (stop.IsString()) {
-					stops.push_back(stop.AsString());
+			if (ready) {
+				catalogue.AddBus(name, transport_catalogue::RouteRange(route.data(), route.data() + route.size()), ring_route);
+			} else {
+				PendingBus pending{ name, {}, ring_route };
+				for (const auto& stop : bus.at("stops"s).AsArray()) {
+					if (stop.IsString()) {
+						pending.stops.push_back(stop.AsString());
+					}
 				}
+				pending_buses.push_back(std::move(pending));
 			}
-			catalogue.AddBus(item.AsMap().at("name"s).AsString(), stops, item.AsMap().at("is_roundtrip"s).AsBool());
 		}
 	}
+
+	for (const auto& [from, to, distance] : pending_distances) {
+		catalogue.SetDistance(from, catalogue.GetStopId(to), distance);
+	}
+
+	std::vector<std::string_view> stops;
+	for (const auto& bus : pending_buses) {
+		stops.assign(bus.stops.begin(), bus.stops.end());
+		catalogue.AddBus(bus.name, stops, bus.ring_route);
+	}
 }
 
 bool JSONReader::IsStop(const json::Node& item) {
@@ -129,23 +266,22 @@ bool JSONReader::IsBus(const json::Node& item) {
 	return false;
 }
 
-const json::Document JSONReader::GetResponses(const request_handler::RequestHandler& handler,
-	const json::Array& data) const {
-	json::Array res;
-	
-	for (const auto& req : data) {
-		if (IsBusRequest(req)) {
-			res.push_back(GetBusResponse(handler, req.AsMap()));
-		} else if (IsStopRequest(req)) {
-			res.push_back(GetStopResponse(handler, req.AsMap()));
-		} else if (IsMapRequest(req)) {
-			res.push_back(GetMapResponse(handler, req.AsMap()));
-		} else if (IsRouteRequest(req)) {
-			res.push_back(GetRouteResponse(handler, req.AsMap()));
-		}
+bool JSONReader::WriteResponse(const request_handler::RequestHandler& handler, const json::Node& request,
+	request_handler::RequestHandler::Route& route, json::Writer& writer) const {
+	if (IsBusRequest(request)) {
+		WriteBusResponse(handler, request.AsMap(), writer);
+	} else if (IsStopRequest(request)) {
+		WriteStopResponse(handler, request.AsMap(), writer);
+	} else if (IsMapRequest(request)) {
+		WriteMapResponse(handler, request.AsMap(), writer);
+	} else if (IsRouteRequest(request)) {
+		WriteRouteResponse(handler, request.AsMap(), route, writer);
+	} else if (IsNearbyStopsRequest(request)) {
+		WriteNearbyStopsResponse(handler, request.AsMap(), writer);
+	} else {
+		return false;
 	}
-
-	return { res };
+	return true;
 }
 
 bool JSONReader::IsBusRequest(const json::Node& item) {
@@ -196,51 +332,61 @@ bool JSONReader::IsRouteRequest(const json::Node& item) {
 	return false;
 }
 
-json::Dict JSONReader::GetBusResponse(const request_handler::RequestHandler& handler,
-	const json::Dict& data) {
+bool JSONReader::IsNearbyStopsRequest(const json::Node& item) {
+	if (item.IsMap()) {
+		const auto& req = item.AsMap();
+		if (req.count("type"s) && req.at("type"s) == "NearbyStops"s &&
+			req.count("id"s) && req.at("id"s).IsInt() &&
+			req.count("latitude"s) && req.at("latitude"s).IsDouble() &&
+			req.count("longitude"s) && req.at("longitude"s).IsDouble() &&
+			((req.count("radius"s) && req.at("radius"s).IsDouble()) ||
+			 (req.count("count"s) && req.at("count"s).IsInt()))) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void JSONReader::WriteBusResponse(const request_handler::RequestHandler& handler,
+	const json::Dict& data, json::Writer& writer) {
 	int id = data.at("id"s).AsInt();
 	const auto& name = data.at("name"s).AsString();
-	try {
-		auto stat = handler.GetBusStat(name);
-		json::Dict res = json::Builder{}
-							.StartDict()
-								.Key("request_id").Value(id)
-								.Key("curvature").Value(stat.curvature)
-								.Key("route_length").Value(stat.length)
-								.Key("stop_count").Value(stat.stops)
-								.Key("unique_stop_count").Value(stat.unic_stops)
-							.EndDict()
-						.Build().AsMap();
-		return res;
-	} catch (std::out_of_range&) {
-		return ErrorResponse(id);
-	}
+	const auto stat = handler.GetBusStat(name);
+	if (!stat) {
+		WriteErrorResponse(id, writer);
+		return;
+	}
+	// keys go in the order of a json::Dict
+	writer.StartDict()
+			.Key("curvature"sv).Value(stat->curvature)
+			.Key("request_id"sv).Value(id)
+			.Key("route_length"sv).Value(stat->length)
+			.Key("stop_count"sv).Value(stat->stops)
+			.Key("unique_stop_count"sv).Value(stat->unic_stops)
+		.EndDict();
 }
 
-json::Dict JSONReader::GetStopResponse(const request_handler::RequestHandler& handler,
-	const json::Dict& data) {
+void JSONReader::WriteStopResponse(const request_handler::RequestHandler& handler,
+	const json::Dict& data, json::Writer& writer) {
 	int id = data.at("id"s).AsInt();
 	const auto& name = data.at("name"s).AsString();
-	try {
-		auto stat = handler.GetBusesByStop(name);
-		json::Array buses;
-		for (const auto& bus : stat) {
-			buses.push_back(std::string(bus));
-		}
-		json::Dict res = json::Builder{}
-							.StartDict()
-								.Key("request_id"s).Value(id)
-								.Key("buses"s).Value(buses)
-							.EndDict()
-						.Build().AsMap();
-		return res;
-	} catch (std::out_of_range&) {
-		return ErrorResponse(id);
-	}
+	const auto stat = handler.GetBusesByStop(name);
+	if (!stat) {
+		WriteErrorResponse(id, writer);
+		return;
+	}
+	writer.StartDict()
+			.Key("buses"sv).StartArray();
+	for (const auto bus : *stat) {
+		writer.Value(handler.GetBusName(bus));
+	}
+	writer.EndArray()
+			.Key("request_id"sv).Value(id)
+		.EndDict();
 }
 
-json::Dict JSONReader::GetMapResponse(const request_handler::RequestHandler& handler,
-	const json::Dict& data) const {
+void JSONReader::WriteMapResponse(const request_handler::RequestHandler& handler,
+	const json::Dict& data, json::Writer& writer) const {
 
 	int id = data.at("id"s).AsInt();
 	std::ostringstream out;
@@ -248,65 +394,75 @@ json::Dict JSONReader::GetMapResponse(const request_handler::RequestHandler& han
 		const auto map = handler.RenderMap();
 
 		map.Render(out);
-
-		json::Dict res = json::Builder{}
-							.StartDict()
-								.Key("request_id"s).Value(id)
-								.Key("map"s).Value(out.str())
-							.EndDict()
-						.Build().AsMap();
-		return res;
 	} catch (std::out_of_range&) {
-		return ErrorResponse(id);
+		WriteErrorResponse(id, writer);
+		return;
 	}
+	writer.StartDict()
+			.Key("map"sv).Value(out.str())
+			.Key("request_id"sv).Value(id)
+		.EndDict();
 }
 
-json::Dict JSONReader::GetRouteResponse(const request_handler::RequestHandler& handler,
-	const json::Dict& data) const {
+void JSONReader::WriteRouteResponse(const request_handler::RequestHandler& handler, const json::Dict& data,
+	request_handler::RequestHandler::Route& route, json::Writer& writer) {
 
 	int id = data.at("id"s).AsInt();
-		
-	try {
-		const auto route = handler.BuildRoute(data.at("from"s).AsString(), data.at("to"s).AsString());
 
-		if (!route.has_value()) {
-			return ErrorResponse(id);
-		}
-		json::Array items;
-
-		int wait_time = handler.GetTransportRouter().GetRouterSettings().bus_wait_time;
-
-		for (const auto& item : route->route) {
-			json::Dict wait_item = json::Builder{}
-										.StartDict()
-											.Key("stop_name"s).Value(std::string(item.from))																								
-											.Key("time"s).Value(wait_time)
-											.Key("type"s).Value("Wait"s)
-										.EndDict()
-									.Build().AsMap();
-			items.push_back(wait_item);
-			json::Dict go_item = json::Builder{}
-									.StartDict()											
-										.Key("bus"s).Value(std::string(item.bus_name))
-										.Key("span_count"s).Value(item.span_count)
-										.Key("time"s).Value(item.total_time - wait_time)
-										.Key("type"s).Value("Bus"s)
-									.EndDict()
-								.Build().AsMap();				
-			items.push_back(go_item);
-		}
-		json::Dict res = json::Builder{}
-							.StartDict()
-								.Key("request_id"s).Value(id)
-								.Key("total_time"s).Value(route->total_time)
-								.Key("items"s).Value(items)
-							.EndDict()
-						.Build().AsMap();
-		return res;
-		
-	} catch (std::out_of_range&) {
-		return ErrorResponse(id);
+	if (!handler.BuildRoute(data.at("from"s).AsString(), data.at("to"s).AsString(), route)) {
+		WriteErrorResponse(id, writer);
+		return;
+	}
+
+	int wait_time = handler.GetTransportRouter().GetRouterSettings().bus_wait_time;
+
+	writer.StartDict()
+			.Key("items"sv).StartArray();
+	for (const auto& item : route.route) {
+		writer.StartDict()
+				.Key("stop_name"sv).Value(handler.GetStopName(item.from))
+				.Key("time"sv).Value(wait_time)
+				.Key("type"sv).Value("Wait"sv)
+			.EndDict();
+		writer.StartDict()
+				.Key("bus"sv).Value(handler.GetBusName(item.bus))
+				.Key("span_count"sv).Value(item.span_count)
+				.Key("time"sv).Value(item.total_time - wait_time)
+				.Key("type"sv).Value("Bus"sv)
+			.EndDict();
+	}
+	writer.EndArray()
+			.Key("request_id"sv).Value(id)
+			.Key("total_time"sv).Value(route.total_time)
+		.EndDict();
+}
+
+void JSONReader::WriteNearbyStopsResponse(const request_handler::RequestHandler& handler,
+	const json::Dict& data, json::Writer& writer) {
+	int id = data.at("id"s).AsInt();
+	const geo::Coordinates center{ data.at("latitude"s).AsDouble(), data.at("longitude"s).AsDouble() };
+
+	// either limit may be omitted
+	double radius = std::numeric_limits<double>::infinity();
+	if (data.count("radius"s) && data.at("radius"s).IsDouble()) {
+		radius = data.at("radius"s).AsDouble();
+	}
+	size_t count = std::numeric_limits<size_t>::max();
+	if (data.count("count"s) && data.at("count"s).IsInt()) {
+		count = static_cast<size_t>(std::max(0, data.at("count"s).AsInt()));
+	}
+
+	writer.StartDict()
+			.Key("request_id"sv).Value(id)
+			.Key("stops"sv).StartArray();
+	for (const auto& stop : handler.GetNearbyStops(center, radius, count)) {
+		writer.StartDict()
+				.Key("distance"sv).Value(stop.distance)
+				.Key("name"sv).Value(handler.GetStopName(stop.id))
+			.EndDict();
 	}
+	writer.EndArray()
+		.EndDict();
 }
 
 map_renderer::RenderSettings JSONReader::BuildRenderSettings(const json::Dict& data) {
@@ -399,13 +555,11 @@ svg::Point JSONReader::GetOffset(const json::Array& item) {
 	return res;
 }
 
-json::Dict ErrorResponse(int id) {
-	return json::Builder{}
-			.StartDict()
-				.Key("request_id"s).Value(id)
-				.Key("error_message"s).Value("not found"s)
-			.EndDict()
-		.Build().AsMap();
+void WriteErrorResponse(int id, json::Writer& writer) {
+	writer.StartDict()
+			.Key("error_message"sv).Value("not found"sv)
+			.Key("request_id"sv).Value(id)
+		.EndDict();
 }
 
 } // namespace json_reader
\ No newline at end of file
@@ -1,13 +1,15 @@
 #pragma once
 
+#include <functional>
 #include <iostream>
 #include <optional>
+#include <vector>
 
 #include "json.h"
 #include "transport_catalogue.h"
 #include "request_handler.h"
 #include "map_renderer.h"
-#include "json_builder.h"
+#include "json_writer.h"
 #include "transport_router.h"
 #include "serialization.h"
 
@@ -17,9 +19,22 @@ class JSONReader final {
 public:
 	JSONReader(std::istream& input);
 
-	bool LoadDataToTransportCatalogue(transport_catalogue::TransportCatalogue& catalogue) const;
+	// reads the document loading base requests into the catalogue while they're being read,
+	// so they're never kept whole; the document keeps everything else
+	JSONReader(std::string_view input, transport_catalogue::TransportCatalogue& catalogue);
 
-	void PrintResponses(const request_handler::RequestHandler& handler, std::ostream& output) const;
+	// compact responses are printed without whitespaces
+	void PrintResponses(const request_handler::RequestHandler& handler, std::ostream& output,
+		bool compact = false) const;
+
+	// reads the document but its stat requests, which are left in input for
+	// PrintResponses(handler, input, output), so input must outlive the reader
+	static JSONReader LoadWithoutStatRequests(std::string_view input);
+
+	// reads stat requests of input one by one and prints every response as soon as it's ready,
+	// the output is the same as of PrintResponses(handler, output, compact) for the whole document
+	void PrintResponses(const request_handler::RequestHandler& handler, std::string_view input,
+		std::ostream& output, bool compact = false) const;
 
 	std::optional<map_renderer::RenderSettings> GetRenderSettings() const;
 
@@ -27,34 +42,63 @@ public:
 
 	std::optional<serializer::SerializerSettings> GetSerializerSettings() const;
 
+	// estimate of the memory taken by the parsed document
+	memory_usage::Report GetMemoryUsage() const;
+
 private:
+	JSONReader();
+
 	json::Document document_;
 
-	void LoadStops(transport_catalogue::TransportCatalogue& catalogue, const json::Array& data) const;
-	void LoadBuses(transport_catalogue::TransportCatalogue& catalogue, const json::Array& data) const;
+	// a bus read before some of its stops, or after another such bus
+	struct PendingBus {
+		std::string name;
+		std::vector<std::string> stops;
+		bool ring_route = false;
+	};
+
+	// a distance to a stop not read yet
+	struct PendingDistance {
+		domain::StopId from = 0;
+		std::string to;
+		int distance = 0;
+	};
+
+	// members of the top object of input not taken by take(key, reader),
+	// which reads the value of a member it takes
+	static json::Node LoadMembers(std::string_view input,
+		const std::function<bool(const std::string&, json::StreamReader&)>& take);
+
+	static void LoadBaseRequests(json::StreamReader& reader, transport_catalogue::TransportCatalogue& catalogue);
 
 	static bool IsStop(const json::Node& item);
 	static bool IsBus(const json::Node& item);
 
-	const json::Document GetResponses(const request_handler::RequestHandler& handler,
-		const json::Array& data) const;
+	// false for requests of unknown types, nothing is written then. The route is scratch space
+	// of the caller, reused by Route requests so that finding a route doesn't allocate
+	bool WriteResponse(const request_handler::RequestHandler& handler, const json::Node& request,
+		request_handler::RequestHandler::Route& route, json::Writer& writer) const;
 
 	static bool IsBusRequest(const json::Node& item);
 	static bool IsStopRequest(const json::Node& item);
 	static bool IsMapRequest(const json::Node& item);
 	static bool IsRouteRequest(const json::Node& item);
+	static bool IsNearbyStopsRequest(const json::Node& item);
+
+	static void WriteBusResponse(const request_handler::RequestHandler& handler,
+		const json::Dict& data, json::Writer& writer);
 
-	static json::Dict GetBusResponse(const request_handler::RequestHandler& handler,
-		const json::Dict& data);
+	static void WriteStopResponse(const request_handler::RequestHandler& handler,
+		const json::Dict& data, json::Writer& writer);
 
-	static json::Dict GetStopResponse(const request_handler::RequestHandler& handler,
-		const json::Dict& data);
+	void WriteMapResponse(const request_handler::RequestHandler& handler,
+		const json::Dict& data, json::Writer& writer) const;
 
-	json::Dict GetMapResponse(const request_handler::RequestHandler& handler,
-		const json::Dict& data) const;
+	static void WriteRouteResponse(const request_handler::RequestHandler& handler, const json::Dict& data,
+		request_handler::RequestHandler::Route& route, json::Writer& writer);
 
-	json::Dict GetRouteResponse(const request_handler::RequestHandler& handler,
-		const json::Dict& data) const;
+	static void WriteNearbyStopsResponse(const request_handler::RequestHandler& handler,
+		const json::Dict& data, json::Writer& writer);
 
 	static map_renderer::RenderSettings BuildRenderSettings(const json::Dict& data);
 	static transport_router::RouterSettings BuildRouterSettings(const json::Dict& data);
@@ -64,6 +108,6 @@ private:
 
 };
 
-json::Dict ErrorResponse(int id);
+void WriteErrorResponse(int id, json::Writer& writer);
 
 }
\ No newline at end of file
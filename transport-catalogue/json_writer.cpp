@@ -0,0 +1,142 @@
+#include <charconv>
+#include <cstdio>
+#include <stdexcept>
+
+#include "json_writer.h"
+
+using namespace std::literals;
+
+namespace json {
+
+Writer& Writer::Key(std::string_view key) {
+    StartItem();
+    WriteString(key);
+    output_ += compact_ ? ":"sv : ": "sv;
+    after_key_ = true;
+    return *this;
+}
+
+Writer& Writer::Value(std::nullptr_t) {
+    StartItem();
+    output_ += "null"sv;
+    return *this;
+}
+
+Writer& Writer::Value(bool value) {
+    StartItem();
+    output_ += value ? "true"sv : "false"sv;
+    return *this;
+}
+
+Writer& Writer::Value(int value) {
+    StartItem();
+    char buffer[16];
+    const auto res = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    output_.append(buffer, res.ptr);
+    return *this;
+}
+
+Writer& Writer::Value(size_t value) {
+    StartItem();
+    char buffer[24];
+    const auto res = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    output_.append(buffer, res.ptr);
+    return *this;
+}
+
+Writer& Writer::Value(double value) {
+    StartItem();
+    // the format of operator<< of a stream with default settings, as used by Print()
+    char buffer[32];
+    const int size = std::snprintf(buffer, sizeof(buffer), "%g", value);
+    output_.append(buffer, static_cast<size_t>(size));
+    return *this;
+}
+
+Writer& Writer::Value(std::string_view value) {
+    StartItem();
+    WriteString(value);
+    return *this;
+}
+
+Writer& Writer::Value(const char* value) {
+    return Value(std::string_view(value));
+}
+
+Writer& Writer::StartDict() {
+    StartContainer('{');
+    return *this;
+}
+
+Writer& Writer::EndDict() {
+    EndContainer('}');
+    return *this;
+}
+
+Writer& Writer::StartArray() {
+    StartContainer('[');
+    return *this;
+}
+
+Writer& Writer::EndArray() {
+    EndContainer(']');
+    return *this;
+}
+
+void Writer::StartItem() {
+    if (after_key_) {
+        // the value of a key goes right after it
+        after_key_ = false;
+        return;
+    }
+    if (depth_ == 0) {
+        return;
+    }
+
+    const uint64_t bit = uint64_t{ 1 } << (depth_ - 1);
+    if (has_items_ & bit) {
+        output_ += ',';
+        if (!compact_) {
+            output_ += '\n';
+        }
+    }
+    has_items_ |= bit;
+    WriteIndent(depth_);
+}
+
+void Writer::StartContainer(char bracket) {
+    if (depth_ == MAX_DEPTH) {
+        throw std::logic_error("Too deep document for the writer"s);
+    }
+    StartItem();
+    output_ += bracket;
+    if (!compact_) {
+        output_ += '\n';
+    }
+    ++depth_;
+    has_items_ &= ~(uint64_t{ 1 } << (depth_ - 1));
+}
+
+void Writer::EndContainer(char bracket) {
+    if (depth_ == 0) {
+        throw std::logic_error("No container to end"s);
+    }
+    --depth_;
+    if (!compact_) {
+        output_ += '\n';
+        WriteIndent(depth_);
+    }
+    output_ += bracket;
+}
+
+void Writer::WriteIndent(int depth) {
+    if (!compact_) {
+        output_.append(static_cast<size_t>(depth * INDENT_STEP), ' ');
+    }
+}
+
+void Writer::WriteString(std::string_view str) {
+    WriteEscaped(str, output_);
+}
+
+}  // namespace json
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "json.h"
+
+namespace json {
+
+// Writes a document straight into a string, no nodes are built. Calls come in the same order
+// as with Builder, which isn't checked. The pretty layout is the one of Print(),
+// the compact one has no whitespaces. Nothing is allocated but the output itself
+class Writer final {
+public:
+    explicit Writer(std::string& output, bool compact = false)
+        : output_(output)
+        , compact_(compact) {}
+
+    Writer& Key(std::string_view key);
+
+    Writer& Value(std::nullptr_t);
+    Writer& Value(bool value);
+    Writer& Value(int value);
+    // sizes and counts, which may not fit into int
+    Writer& Value(size_t value);
+    Writer& Value(double value);
+    Writer& Value(std::string_view value);
+    // without it string literals would be taken for bools
+    Writer& Value(const char* value);
+
+    Writer& StartDict();
+    Writer& EndDict();
+
+    Writer& StartArray();
+    Writer& EndArray();
+
+private:
+    static constexpr int INDENT_STEP = 4;
+    static constexpr int MAX_DEPTH = 64;
+
+    std::string& output_;
+    bool compact_;
+    // containers opened and not closed yet
+    int depth_ = 0;
+    // bit i is set once the container at depth i + 1 has an item
+    uint64_t has_items_ = 0;
+    bool after_key_ = false;
+
+    // a separator and an indent before the next item of the current container
+    void StartItem();
+    void StartContainer(char bracket);
+    void EndContainer(char bracket);
+    void WriteIndent(int depth);
+    void WriteString(std::string_view str);
+};
+
+}  // namespace json
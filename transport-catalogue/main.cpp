@@ -8,26 +8,52 @@
 #include "map_renderer.h"
 #include "transport_router.h"
 #include "serialization.h"
+#include "snapshot.h"
 
 using namespace std::literals;
 
 void PrintUsage(std::ostream& stream = std::cerr) {
-    stream << "Usage: transport_catalogue [make_base|process_requests]\n"sv;
+    stream << "Usage: transport_catalogue [make_base|process_requests|serve_requests] [--memory-report] [--compact]\n"sv;
+}
+
+// memory taken by every major structure, printed to stderr as JSON so responses stay untouched
+void PrintMemoryReport(const json_reader::JSONReader& json, const transport_catalogue::TransportCatalogue& catalogue,
+    const map_renderer::MapRenderer& renderer, const transport_router::TransportRouter& router) {
+    memory_usage::Print({
+        { "catalogue"s, catalogue.GetMemoryUsage() },
+        { "router"s, router.GetMemoryUsage() },
+        { "renderer"s, renderer.GetMemoryUsage() },
+        { "json"s, json.GetMemoryUsage() }
+    }, std::cerr);
 }
 
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
+    if (argc < 2) {
         PrintUsage();
         return 1;
     }
 
     const std::string_view mode(argv[1]);
+    bool memory_report = false;
+    // responses without whitespaces
+    bool compact = false;
+    for (int i = 2; i < argc; ++i) {
+        if (argv[i] == "--memory-report"sv) {
+            memory_report = true;
+        } else if (argv[i] == "--compact"sv) {
+            compact = true;
+        } else {
+            PrintUsage();
+            return 1;
+        }
+    }
 
     if (mode == "make_base"sv) {
-        json_reader::JSONReader json(std::cin);
-
+        // the whole input is parsed from one buffer, a redirected file is mapped,
+        // base requests go into the catalogue as they're read
         transport_catalogue::TransportCatalogue catalog;
-        json.LoadDataToTransportCatalogue(catalog);
+        json_reader::JSONReader json(json::InputBuffer::FromStdin().GetView(), catalog);
+        catalog.Freeze();
         map_renderer::MapRenderer renderer(json.GetRenderSettings().value());
         transport_router::TransportRouter router(json.GetRouterSettings().value());
 
@@ -35,22 +61,49 @@ int main(int argc, char* argv[]) {
                 
         serializer::Serializer serializer(json.GetSerializerSettings().value(), catalog, renderer, router);
 
-        serializer.Serialize();
+        if (!serializer.Serialize()) {
+            std::cerr << "Failed to write the base\n"sv;
+            return 1;
+        }
+
+        if (memory_report) {
+            PrintMemoryReport(json, catalog, renderer, router);
+        }
 
     } else if (mode == "process_requests"sv) {
-        json_reader::JSONReader json(std::cin);
+        // the whole input is parsed from one buffer, a redirected file is mapped,
+        // stat requests are answered one by one while they're being read
+        const auto input = json::InputBuffer::FromStdin();
+        const auto json = json_reader::JSONReader::LoadWithoutStatRequests(input.GetView());
 
-        transport_catalogue::TransportCatalogue catalog;
-        map_renderer::MapRenderer renderer(map_renderer::RenderSettings{});
-        transport_router::TransportRouter router(transport_router::RouterSettings{});
+        auto loaded = snapshot::LoadSnapshot(json.GetSerializerSettings().value());
+        snapshot::SnapshotHolder holder(loaded ? loaded : std::make_shared<const snapshot::Snapshot>());
 
-        serializer::Serializer serializer(json.GetSerializerSettings().value(), catalog, renderer, router);
+        const auto current = holder.Get();
+        json.PrintResponses(current->handler, input.GetView(), std::cout, compact);
+
+        if (memory_report) {
+            PrintMemoryReport(json, current->catalogue, current->renderer, current->router);
+        }
+
+    } else if (mode == "serve_requests"sv) {
+        // the first document names the base, then every document is answered
+        // with the base loaded last, the base is reloaded once the file is replaced
+        json_reader::JSONReader json(std::cin);
+        const auto settings = json.GetSerializerSettings().value();
 
-        serializer.Deserialize();
+        auto loaded = snapshot::LoadSnapshot(settings);
+        snapshot::SnapshotHolder holder(loaded ? loaded : std::make_shared<const snapshot::Snapshot>());
+        snapshot::BaseReloader reloader(settings, holder);
 
-        request_handler::RequestHandler handler(catalog, renderer, router);
+        json.PrintResponses(holder.Get()->handler, std::cout, compact);
+        std::cout << std::endl;
 
-        json.PrintResponses(handler, std::cout);
+        while (std::cin >> std::ws && std::cin.peek() != std::char_traits<char>::eof()) {
+            json_reader::JSONReader next(std::cin);
+            next.PrintResponses(holder.Get()->handler, std::cout, compact);
+            std::cout << std::endl;
+        }
 
     } else {
         PrintUsage();
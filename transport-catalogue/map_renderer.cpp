@@ -4,19 +4,20 @@
 
 namespace map_renderer {
 
-void MapRenderer::RenderMap(const Stops& stops, const Buses& buses, svg::Document& document) const {
-	std::vector<geo::Coordinates> coordinates;
+void MapRenderer::RenderMap(const transport_catalogue::TransportCatalogue& catalogue,
+	const Stops& stops, const Buses& buses, svg::Document& document) const {
+	std::vector<geo::StoredCoordinates> coordinates;
 
-	for (const auto& [name, ptr] : stops) {
-		coordinates.emplace_back(ptr->coordinates);
+	for (const auto stop : stops) {
+		coordinates.emplace_back(catalogue.GetStopCoordinates(stop));
 	}
 
 	const SphereProjector proj{ coordinates.begin(), coordinates.end(), settings_.width, settings_.height, settings_.padding };
 
-	RenderBusLines(buses, document, proj);
-	RenderBusNames(buses, document, proj);
-	RenderStops(stops, document, proj);
-	RenderStopNames(stops, document, proj);
+	RenderBusLines(catalogue, buses, document, proj);
+	RenderBusNames(catalogue, buses, document, proj);
+	RenderStops(catalogue, stops, document, proj);
+	RenderStopNames(catalogue, stops, document, proj);
 }
 
 void MapRenderer::SetSettings(RenderSettings settings) {
@@ -27,12 +28,31 @@ const RenderSettings& MapRenderer::GetSettings() const {
 	return settings_;
 }
 
-void MapRenderer::RenderBusLines(const Buses& buses, svg::Document& document, const SphereProjector& proj) const {
+memory_usage::Report MapRenderer::GetMemoryUsage() const {
+	using namespace memory_usage;
+
+	size_t settings = sizeof(settings_) + GetVectorBytes(settings_.color_palette);
+	for (const auto& color : settings_.color_palette) {
+		if (const auto* name = std::get_if<std::string>(&color)) {
+			settings += GetStringBytes(*name);
+		}
+	}
+	if (const auto* name = std::get_if<std::string>(&settings_.underlayer_color)) {
+		settings += GetStringBytes(*name);
+	}
+
+	return { { "render_settings", settings } };
+}
+
+void MapRenderer::RenderBusLines(const transport_catalogue::TransportCatalogue& catalogue,
+	const Buses& buses, svg::Document& document, const SphereProjector& proj) const {
 	auto colors_count = settings_.color_palette.size();
 	size_t cur_color = 0;
 
-	for (const auto& [name, ptr] : buses) {
-		if (ptr->route.size()) {
+	for (const auto id : buses) {
+		const auto& bus = catalogue.GetBus(id);
+		const auto route = catalogue.GetRoute(id);
+		if (route.size()) {
 			svg::Polyline line;
 			line.SetStrokeColor(settings_.color_palette.at(cur_color % colors_count))
 				.SetFillColor(svg::NoneColor)
@@ -40,12 +60,12 @@ void MapRenderer::RenderBusLines(const Buses& buses, svg::Document& document, co
 				.SetStrokeLineCap(svg::StrokeLineCap::ROUND)
 				.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
 
-			for (const auto& stop : ptr->route) {
-				line.AddPoint(proj(stop->coordinates));
+			for (const auto stop : route) {
+				line.AddPoint(proj(catalogue.GetStopCoordinates(stop)));
 			}
-			if (!ptr->ring_route) {
-				for (auto it = std::next(ptr->route.rbegin()); it < ptr->route.rend(); ++it) {
-					line.AddPoint(proj((*it)->coordinates));
+			if (!bus.ring_route) {
+				for (auto it = std::next(std::make_reverse_iterator(route.end())); it < std::make_reverse_iterator(route.begin()); ++it) {
+					line.AddPoint(proj(catalogue.GetStopCoordinates(*it)));
 				}
 			}
 			document.Add(line);
@@ -55,15 +75,18 @@ void MapRenderer::RenderBusLines(const Buses& buses, svg::Document& document, co
 
 }
 
-void MapRenderer::RenderBusNames(const Buses& buses, svg::Document& document, const SphereProjector& proj) const {
+void MapRenderer::RenderBusNames(const transport_catalogue::TransportCatalogue& catalogue,
+	const Buses& buses, svg::Document& document, const SphereProjector& proj) const {
 	auto colors_count = settings_.color_palette.size();
 	size_t cur_color = 0;
 
-	for (const auto& [name, ptr] : buses) {
-		if (ptr->route.size()) {
+	for (const auto id : buses) {
+		const auto& bus = catalogue.GetBus(id);
+		const auto route = catalogue.GetRoute(id);
+		if (route.size()) {
 			svg::Text text, text_background;
-			text.SetData(std::string(name))
-				.SetPosition(proj(ptr->route.front()->coordinates))
+			text.SetData(std::string(catalogue.GetBusName(id)))
+				.SetPosition(proj(catalogue.GetStopCoordinates(route.front())))
 				.SetOffset(settings_.bus_label_offset)
 				.SetFontSize(static_cast<std::uint32_t>(settings_.bus_label_font_size))
 				.SetFontFamily("Verdana").SetFontWeight("bold");
@@ -76,9 +99,9 @@ void MapRenderer::RenderBusNames(const Buses& buses, svg::Document& document, co
 				.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
 			document.Add(text_background);
 			document.Add(text);
-			if (!(ptr->ring_route) && ptr->route.back() != ptr->route.front()) {
-				text.SetPosition(proj(ptr->route.back()->coordinates));
-				text_background.SetPosition(proj(ptr->route.back()->coordinates));
+			if (!bus.ring_route && route.back() != route.front()) {
+				text.SetPosition(proj(catalogue.GetStopCoordinates(route.back())));
+				text_background.SetPosition(proj(catalogue.GetStopCoordinates(route.back())));
 				document.Add(text_background);
 				document.Add(text);
 			}
@@ -87,20 +110,22 @@ void MapRenderer::RenderBusNames(const Buses& buses, svg::Document& document, co
 	}
 }
 
-void MapRenderer::RenderStops(const Stops& stops, svg::Document& document, const SphereProjector& proj) const {
-	for (const auto& [name, ptr] : stops) {
+void MapRenderer::RenderStops(const transport_catalogue::TransportCatalogue& catalogue,
+	const Stops& stops, svg::Document& document, const SphereProjector& proj) const {
+	for (const auto id : stops) {
 		svg::Circle circle;
-		circle.SetCenter(proj(ptr->coordinates)).
+		circle.SetCenter(proj(catalogue.GetStopCoordinates(id))).
 			SetRadius(settings_.stop_radius).SetFillColor("white");
 		document.Add(circle);
 	}
 }
 
-void MapRenderer::RenderStopNames(const Stops& stops, svg::Document& document, const SphereProjector& proj) const {
-	for (const auto& [name, ptr] : stops) {
+void MapRenderer::RenderStopNames(const transport_catalogue::TransportCatalogue& catalogue,
+	const Stops& stops, svg::Document& document, const SphereProjector& proj) const {
+	for (const auto id : stops) {
 		svg::Text text, text_background;
-		text.SetData(std::string(name))
-			.SetPosition(proj(ptr->coordinates))
+		text.SetData(std::string(catalogue.GetStopName(id)))
+			.SetPosition(proj(catalogue.GetStopCoordinates(id)))
 			.SetOffset(settings_.stop_label_offset)
 			.SetFontSize(static_cast<std::uint32_t>(settings_.stop_label_font_size))
 			.SetFontFamily("Verdana");
@@ -123,6 +148,10 @@ svg::Point SphereProjector::operator()(geo::Coordinates coords) const {
 	};
 }
 
+svg::Point SphereProjector::operator()(geo::FixedCoordinates coords) const {
+	return (*this)(geo::ToDouble(coords));
+}
+
 bool IsZero(double value) {
 	return std::abs(value) < EPSILON;
 }
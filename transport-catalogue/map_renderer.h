@@ -1,13 +1,14 @@
 #pragma once
 
 #include <algorithm>
-#include <map>
-#include <unordered_map>
+#include <vector>
 #include <string>
 
 #include "svg.h"
 #include "geo.h"
 #include "domain.h"
+#include "transport_catalogue.h"
+#include "memory_usage.h"
 
 namespace map_renderer {
 
@@ -32,8 +33,9 @@ struct RenderSettings {
     std::vector<svg::Color> color_palette;
 };
 
-using Buses = std::map<std::string_view, const domain::Bus*>;
-using Stops = std::map<std::string_view, const domain::Stop*>;
+// ids of catalogue buses and stops in the order they are drawn
+using Buses = std::vector<domain::BusId>;
+using Stops = std::vector<domain::StopId>;
 
 class SphereProjector;
 
@@ -45,15 +47,22 @@ public:
 
     const RenderSettings& GetSettings() const;
 
-    void RenderMap(const Stops& stops, const Buses& buses, svg::Document& document) const;
+    memory_usage::Report GetMemoryUsage() const;
+
+    void RenderMap(const transport_catalogue::TransportCatalogue& catalogue,
+        const Stops& stops, const Buses& buses, svg::Document& document) const;
 
 private:
     RenderSettings settings_;
 
-    void RenderBusLines(const Buses& buses, svg::Document& document, const SphereProjector& proj) const;
-    void RenderBusNames(const Buses& buses, svg::Document& document, const SphereProjector& proj) const;
-    void RenderStops(const Stops& stops, svg::Document& document, const SphereProjector& proj) const;
-    void RenderStopNames(const Stops& stops, svg::Document& document, const SphereProjector& proj) const;
+    void RenderBusLines(const transport_catalogue::TransportCatalogue& catalogue,
+        const Buses& buses, svg::Document& document, const SphereProjector& proj) const;
+    void RenderBusNames(const transport_catalogue::TransportCatalogue& catalogue,
+        const Buses& buses, svg::Document& document, const SphereProjector& proj) const;
+    void RenderStops(const transport_catalogue::TransportCatalogue& catalogue,
+        const Stops& stops, svg::Document& document, const SphereProjector& proj) const;
+    void RenderStopNames(const transport_catalogue::TransportCatalogue& catalogue,
+        const Stops& stops, svg::Document& document, const SphereProjector& proj) const;
 };
 
 class SphereProjector final {
@@ -64,6 +73,8 @@ public:
 
     svg::Point operator()(geo::Coordinates coords) const;
 
+    svg::Point operator()(geo::FixedCoordinates coords) const;
+
 private:
     double padding_;
     double min_lon_ = 0;
@@ -86,14 +97,14 @@ SphereProjector::SphereProjector(PointInputIt points_begin, PointInputIt points_
     const auto [left_it, right_it] = std::minmax_element(
         points_begin, points_end,
         [](auto lhs, auto rhs) { return lhs.lng < rhs.lng; });
-    min_lon_ = left_it->lng;
-    const double max_lon = right_it->lng;
+    min_lon_ = geo::ToDouble(*left_it).lng;
+    const double max_lon = geo::ToDouble(*right_it).lng;
 
     const auto [bottom_it, top_it] = std::minmax_element(
         points_begin, points_end,
         [](auto lhs, auto rhs) { return lhs.lat < rhs.lat; });
-    const double min_lat = bottom_it->lat;
-    max_lat_ = top_it->lat;
+    const double min_lat = geo::ToDouble(*bottom_it).lat;
+    max_lat_ = geo::ToDouble(*top_it).lat;
 
     std::optional<double> width_zoom;
     if (!IsZero(max_lon - min_lon_)) {
@@ -0,0 +1,27 @@
+#include <ostream>
+
+#include "memory_usage.h"
+#include "json_writer.h"
+
+namespace memory_usage {
+
+void Print(const Reports& reports, std::ostream& output) {
+	std::string buffer;
+	json::Writer writer(buffer, true);
+	size_t total = 0;
+
+	writer.StartDict();
+	for (const auto& [component, report] : reports) {
+		writer.Key(component).StartDict();
+		for (const auto& [part, bytes] : report) {
+			writer.Key(part).Value(bytes);
+		}
+		writer.Key("total").Value(GetTotal(report)).EndDict();
+		total += GetTotal(report);
+	}
+	writer.Key("total").Value(total).EndDict();
+
+	output << buffer << '\n';
+}
+
+} // namespace memory_usage
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace memory_usage {
+
+// bytes taken by the named parts of a structure
+using Report = std::map<std::string, size_t>;
+
+template <typename T>
+size_t GetVectorBytes(const std::vector<T>& vector) {
+	return vector.capacity() * sizeof(T);
+}
+
+// heap memory of a string which doesn't fit into its own object
+inline size_t GetStringBytes(const std::string& str) {
+	return str.capacity() > std::string().capacity() ? str.capacity() + 1 : 0;
+}
+
+// estimate for node-based hash tables: the bucket array and a node with a cached hash per element
+template <typename HashTable>
+size_t GetHashTableBytes(const HashTable& table) {
+	return table.bucket_count() * sizeof(void*)
+		+ table.size() * (sizeof(typename HashTable::value_type) + sizeof(void*) + sizeof(size_t));
+}
+
+inline size_t GetTotal(const Report& report) {
+	size_t res = 0;
+	for (const auto& [part, bytes] : report) {
+		res += bytes;
+	}
+	return res;
+}
+
+// reports of several components, printed as one JSON object
+using Reports = std::map<std::string, Report>;
+
+// {"component": {"part": bytes, ..., "total": bytes}, ..., "total": bytes} in one line
+void Print(const Reports& reports, std::ostream& output);
+
+} // namespace memory_usage
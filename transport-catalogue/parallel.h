@@ -0,0 +1,54 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace parallel {
+
+// number of chunks the range [0, count) is split into, not more than available hardware threads
+inline size_t GetChunkCount(size_t count) {
+	const size_t threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	return std::max<size_t>(std::min(threads, count), 1);
+}
+
+// calls func(chunk, begin, end) for each of chunk_count contiguous parts of [0, count),
+// every part in its own thread. Chunk i always precedes chunk i + 1 in [0, count),
+// so per-chunk results concatenated in chunk order don't depend on the thread count
+template <typename Func>
+void ForEachChunk(size_t count, size_t chunk_count, Func func) {
+	if (chunk_count <= 1) {
+		func(size_t{ 0 }, size_t{ 0 }, count);
+		return;
+	}
+
+	std::vector<std::thread> workers;
+	std::vector<std::exception_ptr> errors(chunk_count);
+	workers.reserve(chunk_count - 1);
+
+	auto run_chunk = [&](size_t chunk) {
+		try {
+			func(chunk, count * chunk / chunk_count, count * (chunk + 1) / chunk_count);
+		} catch (...) {
+			errors[chunk] = std::current_exception();
+		}
+	};
+
+	for (size_t chunk = 1; chunk < chunk_count; ++chunk) {
+		workers.emplace_back(run_chunk, chunk);
+	}
+	run_chunk(0);
+
+	for (auto& worker : workers) {
+		worker.join();
+	}
+	for (const auto& error : errors) {
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+}
+
+} // namespace parallel
\ No newline at end of file
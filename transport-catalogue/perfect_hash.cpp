@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+#include "perfect_hash.h"
+
+namespace perfect_hash {
+
+PerfectHash::PerfectHash(const std::vector<std::pair<std::string_view, uint32_t>>& items) {
+	const size_t size = items.size();
+	if (size == 0) {
+		return;
+	}
+
+	std::vector<uint64_t> hashes(size);
+	std::vector<std::vector<size_t>> buckets(size);
+	for (size_t i = 0; i < size; ++i) {
+		hashes[i] = Hash(items[i].first);
+		buckets[Mix(hashes[i], 0) % size].push_back(i);
+	}
+
+	std::vector<size_t> order(size);
+	std::iota(order.begin(), order.end(), size_t{ 0 });
+	std::stable_sort(order.begin(), order.end(), [&buckets](size_t lhs, size_t rhs) {
+		return buckets[lhs].size() > buckets[rhs].size();
+	});
+
+	displacements_.assign(size, 0);
+	values_.assign(size, 0);
+	std::vector<bool> used(size, false);
+	std::vector<size_t> slots;
+
+	// the biggest buckets are placed first, while most slots are free
+	auto it = order.begin();
+	for (; it != order.end() && buckets[*it].size() > 1; ++it) {
+		const auto& bucket = buckets[*it];
+		for (uint32_t seed = 1;; ++seed) {
+			if (seed > static_cast<uint32_t>(INT32_MAX)) {
+				throw std::runtime_error("Failed to build perfect hash function");
+			}
+			slots.clear();
+			for (size_t item : bucket) {
+				const size_t slot = Mix(hashes[item], seed) % size;
+				if (used[slot] || std::find(slots.begin(), slots.end(), slot) != slots.end()) {
+					break;
+				}
+				slots.push_back(slot);
+			}
+			if (slots.size() == bucket.size()) {
+				for (size_t i = 0; i < bucket.size(); ++i) {
+					used[slots[i]] = true;
+					values_[slots[i]] = items[bucket[i]].second;
+				}
+				displacements_[*it] = static_cast<int32_t>(seed);
+				break;
+			}
+		}
+	}
+
+	// single-key buckets just take free slots
+	size_t free_slot = 0;
+	for (; it != order.end() && buckets[*it].size() == 1; ++it) {
+		while (used[free_slot]) {
+			++free_slot;
+		}
+		used[free_slot] = true;
+		values_[free_slot] = items[buckets[*it].front()].second;
+		displacements_[*it] = -static_cast<int32_t>(free_slot) - 1;
+	}
+}
+
+uint32_t PerfectHash::operator()(std::string_view key) const {
+	const size_t size = values_.size();
+	const uint64_t hash = Hash(key);
+	const int32_t displacement = displacements_[Mix(hash, 0) % size];
+
+	if (displacement < 0) {
+		return values_[-(displacement + 1)];
+	}
+	return values_[Mix(hash, static_cast<uint64_t>(displacement)) % size];
+}
+
+bool PerfectHash::IsEmpty() const {
+	return values_.empty();
+}
+
+const std::vector<int32_t>& PerfectHash::GetDisplacements() const {
+	return displacements_;
+}
+
+const std::vector<uint32_t>& PerfectHash::GetValues() const {
+	return values_;
+}
+
+uint64_t PerfectHash::Hash(std::string_view key) {
+	// FNV-1a, the function is stored in the base file, so it mustn't depend on std::hash implementation
+	uint64_t hash = 14695981039346656037ULL;
+	for (const char c : key) {
+		hash ^= static_cast<unsigned char>(c);
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+uint64_t PerfectHash::Mix(uint64_t hash, uint64_t seed) {
+	// splitmix64 finalizer
+	hash += seed * 0x9E3779B97F4A7C15ULL;
+	hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+	return hash ^ (hash >> 31);
+}
+
+} // namespace perfect_hash
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace perfect_hash {
+
+// Minimal perfect hash function over a fixed set of string keys ("hash and displace").
+// Every key of the set is mapped to its own value without probing. A key outside of the set
+// is mapped to some value too, so the caller has to compare the key with the one stored for that value.
+class PerfectHash {
+public:
+	PerfectHash() = default;
+
+	// keys must be unique
+	explicit PerfectHash(const std::vector<std::pair<std::string_view, uint32_t>>& items);
+
+	PerfectHash(std::vector<int32_t> displacements, std::vector<uint32_t> values)
+		: displacements_(std::move(displacements))
+		, values_(std::move(values)) {}
+
+	// the only value the key can have, the function mustn't be empty
+	uint32_t operator()(std::string_view key) const;
+
+	bool IsEmpty() const;
+
+	const std::vector<int32_t>& GetDisplacements() const;
+
+	const std::vector<uint32_t>& GetValues() const;
+
+private:
+	// bucket of a key's hash -> seed of the slot hash for keys of this bucket (> 0)
+	// or the slot itself for a single-key bucket (-slot - 1)
+	std::vector<int32_t> displacements_;
+	// slot -> value
+	std::vector<uint32_t> values_;
+
+	static uint64_t Hash(std::string_view key);
+	static uint64_t Mix(uint64_t hash, uint64_t seed);
+};
+
+} // namespace perfect_hash
\ No newline at end of file
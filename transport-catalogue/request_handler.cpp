@@ -1,5 +1,3 @@
-#include <map>
-
 #include "request_handler.h"
 
 namespace request_handler {
@@ -11,39 +9,49 @@ RequestHandler::RequestHandler(const transport_catalogue::TransportCatalogue& db
 	, renderer_(renderer)
 	, router_(router) {}
 
-domain::BusStat RequestHandler::GetBusStat(const std::string_view& bus_name) const {
-	return db_.GetBusInfo(std::string(bus_name));
+std::optional<domain::BusStat> RequestHandler::GetBusStat(const std::string_view& bus_name) const {
+	return db_.FindBusStat(bus_name);
 }
 
-const std::set<std::string_view>& RequestHandler::GetBusesByStop(const std::string_view& stop_name) const {
-	return db_.GetBusesAtStop(std::string(stop_name));
+std::optional<transport_catalogue::BusesRange> RequestHandler::GetBusesByStop(const std::string_view& stop_name) const {
+	return db_.FindBusesAtStop(stop_name);
 }
 
 svg::Document RequestHandler::RenderMap() const {
 	svg::Document res;
 
-	const auto& buses = db_.GetAllBuses();
-	const auto& stops = db_.GetAllStops();
+	renderer_.RenderMap(db_, db_.GetServedStopsByName(), db_.GetBusesByName(), res);
 
-	map_renderer::Buses ordered_buses;
-	map_renderer::Stops used_stops;
+	return res;
+}
 
-	for (const auto& bus : buses) {
-		ordered_buses.emplace(bus);
+std::optional<RequestHandler::Route> RequestHandler::BuildRoute(std::string_view from, std::string_view to) const {
+	Route res;
+	if (!BuildRoute(from, to, res)) {
+		return std::nullopt;
 	}
-	for (const auto& stop : stops) {
-		if (!db_.GetBusesAtStop(stop.second->name).empty()) {
-			used_stops.emplace(stop);
-		}
+	return res;
+}
+
+bool RequestHandler::BuildRoute(std::string_view from, std::string_view to, Route& route) const {
+	const auto from_id = db_.FindStopId(from);
+	const auto to_id = db_.FindStopId(to);
+	if (!from_id || !to_id) {
+		return false;
 	}
+	return router_.BuildRoute(*from_id, *to_id, route);
+}
 
-	renderer_.RenderMap(used_stops, ordered_buses, res);
+std::vector<spatial_index::Neighbor> RequestHandler::GetNearbyStops(geo::Coordinates center, double radius, size_t count) const {
+	return db_.FindNearbyStops(center, radius, count);
+}
 
-	return res;
+std::string_view RequestHandler::GetBusName(domain::BusId id) const {
+	return db_.GetBusName(id);
 }
 
-std::optional<RequestHandler::Route> RequestHandler::BuildRoute(const std::string& from, const std::string& to) const {
-	return router_.BuildRoute(from, to);
+std::string_view RequestHandler::GetStopName(domain::StopId id) const {
+	return db_.GetStopName(id);
 }
 
 const transport_router::TransportRouter& RequestHandler::GetTransportRouter() const {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <optional>
 #include <string>
 
 #include "transport_catalogue.h"
@@ -16,13 +17,24 @@ public:
                    const map_renderer::MapRenderer& renderer,
                    const transport_router::TransportRouter& router);
 
-    domain::BusStat GetBusStat(const std::string_view& bus_name) const;
+    // lookups return nullopt for unknown names
 
-    const std::set<std::string_view>& GetBusesByStop(const std::string_view& stop_name) const;
+    std::optional<domain::BusStat> GetBusStat(const std::string_view& bus_name) const;
+
+    std::optional<transport_catalogue::BusesRange> GetBusesByStop(const std::string_view& stop_name) const;
 
     svg::Document RenderMap() const;
 
-    std::optional<Route> BuildRoute(const std::string& from, const std::string& to) const;
+    std::optional<Route> BuildRoute(std::string_view from, std::string_view to) const;
+
+    // writes the route to a buffer reused between calls, false if there's no route
+    bool BuildRoute(std::string_view from, std::string_view to, Route& route) const;
+
+    std::vector<spatial_index::Neighbor> GetNearbyStops(geo::Coordinates center, double radius, size_t count) const;
+
+    std::string_view GetBusName(domain::BusId id) const;
+
+    std::string_view GetStopName(domain::StopId id) const;
 
     const transport_router::TransportRouter& GetTransportRouter() const;
 
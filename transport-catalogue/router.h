@@ -29,6 +29,11 @@ public:
 
     std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
 
+    // calls func(edge_id) for the edges of the route from the last one to the first one,
+    // nothing is allocated
+    template <typename Func>
+    std::optional<Weight> WalkRouteBackward(VertexId from, VertexId to, Func func) const;
+
     struct RouteInternalData {
         Weight weight;
         std::optional<EdgeId> prev_edge;
@@ -83,6 +88,10 @@ public:
     RoutesInternalData& GetRoutesInternalData() {
         return routes_internal_data_;
     }
+
+    const RoutesInternalData& GetRoutesInternalData() const {
+        return routes_internal_data_;
+    }
 };
 
 template <typename Weight>
@@ -104,21 +113,32 @@ Router<Weight>::Router(const Graph& graph, bool init)
 template <typename Weight>
 std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
                                                                              VertexId to) const {
+    std::vector<EdgeId> edges;
+    const auto weight = WalkRouteBackward(from, to, [&edges](EdgeId edge_id) {
+        edges.push_back(edge_id);
+    });
+    if (!weight) {
+        return std::nullopt;
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return RouteInfo{*weight, std::move(edges)};
+}
+
+template <typename Weight>
+template <typename Func>
+std::optional<Weight> Router<Weight>::WalkRouteBackward(VertexId from, VertexId to, Func func) const {
     const auto& route_internal_data = routes_internal_data_.at(from).at(to);
     if (!route_internal_data) {
         return std::nullopt;
     }
-    const Weight weight = route_internal_data->weight;
-    std::vector<EdgeId> edges;
     for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
          edge_id;
          edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
     {
-        edges.push_back(*edge_id);
+        func(*edge_id);
     }
-    std::reverse(edges.begin(), edges.end());
-
-    return RouteInfo{weight, std::move(edges)};
+    return route_internal_data->weight;
 }
 
 }  // namespace graph
\ No newline at end of file
@@ -1,78 +1,214 @@
+#include <algorithm>
+#include <cmath>
 #include <fstream>
+#include <stdexcept>
+#include <vector>
 
 #include "serialization.h"
 
 namespace serializer {
 
-void Serializer::Serialize() {
-	std::ofstream ofs(settings_.path, std::ios::binary);
+namespace {
+
+// offsets of compressed sparse rows: one more than rows, from zero up to the size of the indexed array
+template <typename Offsets>
+bool IsValidOffsets(const Offsets& offsets, size_t rows, size_t size) {
+	return static_cast<size_t>(offsets.size()) == rows + 1 && offsets[0] == 0
+		&& std::is_sorted(offsets.begin(), offsets.end()) && offsets[rows] == size;
+}
+
+template <typename Ids>
+bool IsInRange(const Ids& ids, size_t count) {
+	return std::all_of(ids.begin(), ids.end(), [count](uint32_t id) { return id < count; });
+}
+
+// no id repeats, so count ids of them make a permutation
+template <typename Ids>
+bool IsDistinct(const Ids& ids, size_t count) {
+	if (!IsInRange(ids, count)) {
+		return false;
+	}
+	std::vector<bool> seen(count, false);
+	for (const uint32_t id : ids) {
+		if (seen[id]) {
+			return false;
+		}
+		seen[id] = true;
+	}
+	return true;
+}
+
+} // namespace
+
+bool Serializer::Serialize() {
+	// the base is written next to the old one and renamed over it,
+	// so a process reloading the base never sees a half-written file
+	auto tmp_path = settings_.path;
+	tmp_path += ".tmp";
+	std::ofstream ofs(tmp_path, std::ios::binary);
 	if (!ofs.is_open()) {
-		return;
+		return false;
 	}
 	ProtoCatalogue proto_catalogue;
+	proto_catalogue.set_format_version(FORMAT_VERSION);
 
 	SerializeStops(proto_catalogue);
 	SerializeDistances(proto_catalogue);
 	SerializeBuses(proto_catalogue);
+	SerializeNameIndexes(proto_catalogue);
+	SerializeStopBuses(proto_catalogue);
+	SerializeStopGrid(proto_catalogue);
+	SerializeNameOrders(proto_catalogue);
 
 	SerializeRenderSettings(proto_catalogue);
 
 	SerializeTransportRouter(proto_catalogue);
 
-	proto_catalogue.SerializeToOstream(&ofs);
+	// a short write must not replace the good base
+	const bool written = proto_catalogue.SerializeToOstream(&ofs);
+	ofs.close();
+
+	std::error_code error;
+	if (written && ofs) {
+		std::filesystem::rename(tmp_path, settings_.path, error);
+		if (!error) {
+			return true;
+		}
+	}
+	std::filesystem::remove(tmp_path, error);
+	return false;
 }
 
-void Serializer::Deserialize() {
+bool Serializer::Deserialize() {
 	std::ifstream ifs(settings_.path, std::ios::binary);
 	if (!ifs.is_open()) {
-		return;
+		return false;
 	}
 	ProtoCatalogue proto_catalogue;
 
-	proto_catalogue.ParseFromIstream(&ifs);
+	if (!proto_catalogue.ParseFromIstream(&ifs) || !CheckCatalogue(proto_catalogue)) {
+		return false;
+	}
 
+	DeserializeNameIndexes(proto_catalogue); // before stops and buses, so no hash tables are built for their names
+	ReserveCatalogue(proto_catalogue);
 	DeserializeStops(proto_catalogue);
 	DeserializeDistances(proto_catalogue);
-	DeserializeBuses(proto_catalogue);
+	if (!DeserializeBuses(proto_catalogue)) {
+		return false;
+	}
+	DeserializeStopBuses(proto_catalogue);
+	DeserializeStopGrid(proto_catalogue);
+	DeserializeNameOrders(proto_catalogue);
 
 	DeserializeRenderSettings(proto_catalogue);
 
 	DeserializeTransportRouter(proto_catalogue);
+
+	return true;
 }
 
 void Serializer::SerializeStops(ProtoCatalogue& proto_catalogue) {
-	for (const auto& [name, stop] : catalogue_.GetAllStops()) {
+	for (domain::StopId id = 0; id < catalogue_.GetStopCount(); ++id) {
+		const auto coordinates = catalogue_.GetStopCoordinates(id);
 		proto_transport_catalogue::Stop proto_stop;
-		proto_stop.set_name(stop->name);
-		proto_stop.mutable_coordinates()->set_lat(stop->coordinates.lat);
-		proto_stop.mutable_coordinates()->set_lng(stop->coordinates.lng);
+		proto_stop.set_name(std::string(catalogue_.GetStopName(id)));
+		SerializeCoordinates(coordinates, *proto_stop.mutable_coordinates());
 
 		*proto_catalogue.add_stops() = proto_stop;
 	}
+	proto_catalogue.set_fixed_point_coordinates(std::is_same_v<geo::StoredCoordinates, geo::FixedCoordinates>);
+}
+
+void Serializer::SerializeCoordinates(geo::Coordinates coordinates, proto_transport_catalogue::Coordinates& proto_coordinates) {
+	proto_coordinates.set_lat(coordinates.lat);
+	proto_coordinates.set_lng(coordinates.lng);
+}
+
+void Serializer::SerializeCoordinates(geo::FixedCoordinates coordinates, proto_transport_catalogue::Coordinates& proto_coordinates) {
+	proto_coordinates.set_lat_e6(coordinates.lat);
+	proto_coordinates.set_lng_e6(coordinates.lng);
 }
 
 void Serializer::SerializeDistances(ProtoCatalogue& proto_catalogue) {
-	for (const auto& [dir, dist] : catalogue_.GetAllDistances()) {
-		proto_transport_catalogue::Distance proto_dist;
-		proto_dist.set_from(dir.first->name);
-		proto_dist.set_to(dir.second->name);
-		proto_dist.set_distance(dist);
+	const auto& distances = catalogue_.GetRoadDistances();
+	auto proto_distances = proto_catalogue.mutable_distances();
 
-		*proto_catalogue.add_distances() = proto_dist;
-	}
+	proto_distances->mutable_offsets()->Add(distances.offsets.begin(), distances.offsets.end());
+	proto_distances->mutable_neighbors()->Add(distances.neighbors.begin(), distances.neighbors.end());
+	proto_distances->mutable_distances()->Add(distances.distances.begin(), distances.distances.end());
 }
 
 void Serializer::SerializeBuses(ProtoCatalogue& proto_catalogue) {
-	for (const auto& [name, bus] : catalogue_.GetAllBuses()) {
+	for (domain::BusId id = 0; id < catalogue_.GetBusCount(); ++id) {
+		const auto& bus = catalogue_.GetBus(id);
 		proto_transport_catalogue::Bus proto_bus;
-		proto_bus.set_name(bus->name);
-		for (const auto* stop : bus->route) {
-			*proto_bus.mutable_route()->Add() = stop->name;
-		}
-		proto_bus.set_ring_route(bus->ring_route);
+		proto_bus.set_name(std::string(catalogue_.GetBusName(id)));
+		proto_bus.set_route_size(bus.route_size);
+		proto_bus.set_ring_route(bus.ring_route);
+
+		const auto& stat = catalogue_.GetBusStats()[id];
+		auto proto_stat = proto_bus.mutable_stat();
+		proto_stat->set_stops(stat.stops);
+		proto_stat->set_unique_stops(stat.unic_stops);
+		proto_stat->set_length(stat.length);
+		proto_stat->set_curvature(stat.curvature);
 
 		*proto_catalogue.add_buses() = proto_bus;
 	}
+
+	const auto& routes = catalogue_.GetRoutePool();
+	proto_catalogue.mutable_routes()->Add(routes.begin(), routes.end());
+}
+
+void Serializer::SerializeNameIndexes(ProtoCatalogue& proto_catalogue) {
+	*proto_catalogue.mutable_stop_index() = SerializePerfectHash(catalogue_.GetStopIndex());
+	*proto_catalogue.mutable_bus_index() = SerializePerfectHash(catalogue_.GetBusIndex());
+}
+
+proto_transport_catalogue::PerfectHash Serializer::SerializePerfectHash(const perfect_hash::PerfectHash& hash) {
+	proto_transport_catalogue::PerfectHash proto_hash;
+
+	for (const auto displacement : hash.GetDisplacements()) {
+		proto_hash.add_displacements(displacement);
+	}
+	for (const auto value : hash.GetValues()) {
+		proto_hash.add_values(value);
+	}
+
+	return proto_hash;
+}
+
+void Serializer::SerializeStopBuses(ProtoCatalogue& proto_catalogue) {
+	for (const auto offset : catalogue_.GetStopBusesOffsets()) {
+		proto_catalogue.add_stop_buses_offsets(offset);
+	}
+	for (const auto bus : catalogue_.GetStopBuses()) {
+		proto_catalogue.add_stop_buses(bus);
+	}
+}
+
+void Serializer::SerializeStopGrid(ProtoCatalogue& proto_catalogue) {
+	const auto& grid = catalogue_.GetStopGrid().GetGrid();
+	auto proto_grid = proto_catalogue.mutable_stop_grid();
+
+	SerializeCoordinates(grid.min, *proto_grid->mutable_min());
+	proto_grid->set_cell_height(grid.cell_height);
+	proto_grid->set_cell_width(grid.cell_width);
+	proto_grid->set_rows(grid.rows);
+	proto_grid->set_cols(grid.cols);
+	proto_grid->mutable_offsets()->Add(grid.offsets.begin(), grid.offsets.end());
+	proto_grid->mutable_stops()->Add(grid.points.begin(), grid.points.end());
+}
+
+void Serializer::SerializeNameOrders(ProtoCatalogue& proto_catalogue) {
+	const auto& buses = catalogue_.GetBusesByName();
+	const auto& stops = catalogue_.GetStopsByName();
+	const auto& served_stops = catalogue_.GetServedStopsByName();
+
+	proto_catalogue.mutable_buses_by_name()->Add(buses.begin(), buses.end());
+	proto_catalogue.mutable_stops_by_name()->Add(stops.begin(), stops.end());
+	proto_catalogue.mutable_served_stops_by_name()->Add(served_stops.begin(), served_stops.end());
 }
 
 void Serializer::SerializeRenderSettings(ProtoCatalogue& proto_catalogue) {
@@ -149,7 +285,6 @@ proto_svg::Rgba Serializer::SerializeRgba(const svg::Rgba& rgba) {
 
 void Serializer::SerializeTransportRouter(ProtoCatalogue& proto_catalogue) {
 	SerializeRouterSettings(proto_catalogue);
-	SerializeStopIdByName(proto_catalogue);
 	SerializeGraph(proto_catalogue);
 	SerializeRouter(proto_catalogue);
 }
@@ -164,17 +299,6 @@ void Serializer::SerializeRouterSettings(ProtoCatalogue& proto_catalogue) {
 	*proto_catalogue.mutable_router()->mutable_settings() = proto_router_settings;
 }
 
-void Serializer::SerializeStopIdByName(ProtoCatalogue& proto_catalogue) {
-	auto proto_stop_id_by_name = proto_catalogue.mutable_router()->mutable_stop_id_by_name();
-
-	for (auto [name, id] : router_.GetStopsIdByName()) {
-		proto_transport_router::StopIdByName stop_id_by_name;
-		stop_id_by_name.set_name(std::string(name));
-		stop_id_by_name.set_id(static_cast<uint32_t>(id));
-		*proto_stop_id_by_name->Add() = std::move(stop_id_by_name);
-	}
-}
-
 void Serializer::SerializeGraph(ProtoCatalogue& proto_catalogue) {
 	auto proto_graph = proto_catalogue.mutable_router()->mutable_graph();
 
@@ -219,40 +343,256 @@ proto_graph::EdgeWeight
 Serializer::SerializeEdgeWeight(const transport_router::EdgeWeight& weight) const {
 	proto_graph::EdgeWeight proto_weight;
 
-	proto_weight.set_bus_name(std::string(weight.bus_name));
-	proto_weight.set_from(std::string(weight.from));
-	proto_weight.set_to(std::string(weight.to));
+	proto_weight.set_bus(weight.bus);
+	proto_weight.set_from(weight.from);
+	proto_weight.set_to(weight.to);
 	proto_weight.set_span_count(weight.span_count);
 	proto_weight.set_total_time(weight.total_time);
 
 	return proto_weight;
 }
 
+bool Serializer::CheckCatalogue(const ProtoCatalogue& proto_catalogue) {
+	return proto_catalogue.format_version() == FORMAT_VERSION
+		&& CheckDistances(proto_catalogue)
+		&& CheckRoutes(proto_catalogue)
+		&& CheckPerfectHash(proto_catalogue.stop_index(), proto_catalogue.stops_size())
+		&& CheckPerfectHash(proto_catalogue.bus_index(), proto_catalogue.buses_size())
+		&& CheckStopBuses(proto_catalogue)
+		&& CheckStopGrid(proto_catalogue)
+		&& CheckNameOrders(proto_catalogue)
+		&& CheckTransportRouter(proto_catalogue);
+}
+
+bool Serializer::CheckDistances(const ProtoCatalogue& proto_catalogue) {
+	const auto& proto_distances = proto_catalogue.distances();
+	const auto& offsets = proto_distances.offsets();
+	const auto& neighbors = proto_distances.neighbors();
+	const size_t stop_count = proto_catalogue.stops_size();
+
+	if (!IsValidOffsets(offsets, stop_count, neighbors.size()) || neighbors.size() != proto_distances.distances_size()
+		|| !IsInRange(neighbors, stop_count)) {
+		return false;
+	}
+	// distances are found by binary search over rows
+	for (size_t stop = 0; stop < stop_count; ++stop) {
+		if (!std::is_sorted(neighbors.begin() + offsets[stop], neighbors.begin() + offsets[stop + 1])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Serializer::CheckRoutes(const ProtoCatalogue& proto_catalogue) {
+	size_t route_stops = 0;
+	for (const auto& proto_bus : proto_catalogue.buses()) {
+		route_stops += proto_bus.route_size();
+	}
+	return route_stops <= static_cast<size_t>(proto_catalogue.routes_size())
+		&& IsInRange(proto_catalogue.routes(), proto_catalogue.stops_size());
+}
+
+bool Serializer::CheckPerfectHash(const proto_transport_catalogue::PerfectHash& proto_hash, size_t id_count) {
+	// a displacement and a value per distinct name, several buses may share a name
+	const size_t size = proto_hash.values_size();
+	if (static_cast<size_t>(proto_hash.displacements_size()) != size || size > id_count) {
+		return false;
+	}
+	// negative displacements are slots
+	return IsInRange(proto_hash.values(), id_count)
+		&& std::all_of(proto_hash.displacements().begin(), proto_hash.displacements().end(), [size](int32_t displacement) {
+			return displacement >= 0 || -(static_cast<int64_t>(displacement) + 1) < static_cast<int64_t>(size);
+		});
+}
+
+bool Serializer::CheckStopBuses(const ProtoCatalogue& proto_catalogue) {
+	return IsValidOffsets(proto_catalogue.stop_buses_offsets(), proto_catalogue.stops_size(), proto_catalogue.stop_buses_size())
+		&& IsInRange(proto_catalogue.stop_buses(), proto_catalogue.buses_size());
+}
+
+bool Serializer::CheckStopGrid(const ProtoCatalogue& proto_catalogue) {
+	const auto& proto_grid = proto_catalogue.stop_grid();
+	const size_t stop_count = proto_catalogue.stops_size();
+
+	// the grid of no stops is empty, queries don't look into it
+	if (stop_count == 0) {
+		return proto_grid.rows() == 0;
+	}
+	const auto is_cell_size = [](double size) {
+		return std::isfinite(size) && size > 0.0;
+	};
+	const uint64_t cell_count = static_cast<uint64_t>(proto_grid.rows()) * proto_grid.cols();
+	return cell_count > 0 && is_cell_size(proto_grid.cell_height()) && is_cell_size(proto_grid.cell_width())
+		&& std::isfinite(proto_grid.min().lat()) && std::isfinite(proto_grid.min().lng())
+		&& IsValidOffsets(proto_grid.offsets(), cell_count, proto_grid.stops_size())
+		&& IsDistinct(proto_grid.stops(), stop_count) && static_cast<size_t>(proto_grid.stops_size()) == stop_count;
+}
+
+bool Serializer::CheckNameOrders(const ProtoCatalogue& proto_catalogue) {
+	const size_t stop_count = proto_catalogue.stops_size();
+	const auto& offsets = proto_catalogue.stop_buses_offsets();
+
+	if (!IsDistinct(proto_catalogue.buses_by_name(), proto_catalogue.buses_size())
+		|| proto_catalogue.buses_by_name_size() != proto_catalogue.buses_size()
+		|| !IsDistinct(proto_catalogue.stops_by_name(), stop_count)
+		|| static_cast<size_t>(proto_catalogue.stops_by_name_size()) != stop_count
+		|| !IsDistinct(proto_catalogue.served_stops_by_name(), stop_count)) {
+		return false;
+	}
+	// served stops are the ones with buses, the stop to buses index is checked before
+	size_t served_count = 0;
+	for (size_t stop = 0; stop < stop_count; ++stop) {
+		served_count += offsets[stop] != offsets[stop + 1];
+	}
+	return served_count == static_cast<size_t>(proto_catalogue.served_stops_by_name_size())
+		&& std::all_of(proto_catalogue.served_stops_by_name().begin(), proto_catalogue.served_stops_by_name().end(),
+			[&offsets](uint32_t stop) { return offsets[stop] != offsets[stop + 1]; });
+}
+
+bool Serializer::CheckTransportRouter(const ProtoCatalogue& proto_catalogue) {
+	const auto& proto_graph = proto_catalogue.router().graph();
+	const size_t vertex_count = proto_graph.incidence_lists_size();
+	const size_t edge_count = proto_graph.edges_size();
+	const size_t stop_count = proto_catalogue.stops_size();
+	const size_t bus_count = proto_catalogue.buses_size();
+
+	// vertices are stops, a catalogue without stops has no graph
+	if (vertex_count != stop_count && vertex_count != 0) {
+		return false;
+	}
+	for (const auto& proto_edge : proto_graph.edges()) {
+		const auto& proto_weight = proto_edge.weight();
+		if (proto_edge.from() >= vertex_count || proto_edge.to() >= vertex_count
+			|| proto_weight.bus() >= bus_count || proto_weight.from() >= stop_count || proto_weight.to() >= stop_count) {
+			return false;
+		}
+	}
+	for (const auto& proto_list : proto_graph.incidence_lists()) {
+		if (!IsInRange(proto_list.edge_id(), edge_count)) {
+			return false;
+		}
+	}
+
+	const auto& proto_router = proto_catalogue.router().router();
+	if (static_cast<size_t>(proto_router.routes_internal_data_size()) > vertex_count) {
+		return false;
+	}
+	for (const auto& proto_internal_data : proto_router.routes_internal_data()) {
+		if (static_cast<size_t>(proto_internal_data.routes_internal_data_size()) > vertex_count) {
+			return false;
+		}
+		for (const auto& proto_optional_data : proto_internal_data.routes_internal_data()) {
+			const auto& proto_data = proto_optional_data.route_internal_data();
+			if (proto_data.optional_prev_edge_case() == proto_graph::RouteInternalData::kPrevEdge
+				&& proto_data.prev_edge() >= edge_count) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+void Serializer::ReserveCatalogue(ProtoCatalogue& proto_catalogue) {
+	transport_catalogue::CatalogueSizes sizes;
+
+	sizes.stops = proto_catalogue.stops_size();
+	sizes.buses = proto_catalogue.buses_size();
+	sizes.route_stops = proto_catalogue.routes_size();
+	for (const auto& stop : proto_catalogue.stops()) {
+		sizes.name_bytes += stop.name().size();
+	}
+	for (const auto& bus : proto_catalogue.buses()) {
+		sizes.name_bytes += bus.name().size();
+	}
+
+	catalogue_.Reserve(sizes);
+}
+
 void Serializer::DeserializeStops(ProtoCatalogue& proto_catalogue) {
 	for (int i = 0; i < proto_catalogue.stops_size(); ++i) {
 		const proto_transport_catalogue::Stop& proto_stop = proto_catalogue.stops(i);
-		catalogue_.AddStop(proto_stop.name(), 
-			{ proto_stop.coordinates().lat(), proto_stop.coordinates().lng() });
+		const auto& proto_coordinates = proto_stop.coordinates();
+		if (proto_catalogue.fixed_point_coordinates()) {
+			// micro-degrees survive the round trip through double exactly
+			catalogue_.AddStop(proto_stop.name(),
+				geo::ToDouble(geo::FixedCoordinates{ proto_coordinates.lat_e6(), proto_coordinates.lng_e6() }));
+		} else {
+			catalogue_.AddStop(proto_stop.name(),
+				geo::Coordinates{ proto_coordinates.lat(), proto_coordinates.lng() });
+		}
 	}
 }
 
 void Serializer::DeserializeDistances(ProtoCatalogue& proto_catalogue) {
-	for (int i = 0; i < proto_catalogue.distances_size(); ++i) {
-		const proto_transport_catalogue::Distance& proto_dist = proto_catalogue.distances(i);
+	const auto& proto_distances = proto_catalogue.distances();
+	transport_catalogue::RoadDistances distances;
 
-		catalogue_.SetDistance(proto_dist.from(), proto_dist.to(), proto_dist.distance());
-	}
+	distances.offsets.assign(proto_distances.offsets().begin(), proto_distances.offsets().end());
+	distances.neighbors.assign(proto_distances.neighbors().begin(), proto_distances.neighbors().end());
+	distances.distances.assign(proto_distances.distances().begin(), proto_distances.distances().end());
+
+	catalogue_.SetRoadDistances(std::move(distances));
 }
 
-void Serializer::DeserializeBuses(ProtoCatalogue& proto_catalogue) {
+bool Serializer::DeserializeBuses(ProtoCatalogue& proto_catalogue) {
+	std::vector<domain::BusStat> stats;
+	stats.reserve(proto_catalogue.buses_size());
+
+	// routes are read straight from the packed array, without a vector per bus
+	const domain::StopId* route = proto_catalogue.routes().data();
 	for (int i = 0; i < proto_catalogue.buses_size(); ++i) {
 		const proto_transport_catalogue::Bus& proto_bus = proto_catalogue.buses(i);
-		std::vector<std::string> route(proto_bus.route_size());
-		for (int j = 0; j < proto_bus.route_size(); ++j) {
-			route[j] = proto_bus.route(j);
+		domain::BusId id;
+		try {
+			id = catalogue_.AddBus(proto_bus.name(),
+				transport_catalogue::RouteRange{ route, route + proto_bus.route_size() }, proto_bus.ring_route());
+		} catch (std::out_of_range&) {
+			return false;
 		}
-		catalogue_.AddBus(proto_bus.name(), route, proto_bus.ring_route());
+		route += proto_bus.route_size();
+
+		const auto& proto_stat = proto_bus.stat();
+		stats.push_back({ catalogue_.GetBusName(id), proto_stat.stops(), proto_stat.unique_stops(),
+			proto_stat.length(), proto_stat.curvature() });
 	}
+	catalogue_.SetBusStats(std::move(stats));
+	return true;
+}
+
+void Serializer::DeserializeNameIndexes(ProtoCatalogue& proto_catalogue) {
+	catalogue_.SetNameIndexes(DeserializePerfectHash(proto_catalogue.stop_index()),
+		DeserializePerfectHash(proto_catalogue.bus_index()));
+}
+
+perfect_hash::PerfectHash Serializer::DeserializePerfectHash(const proto_transport_catalogue::PerfectHash& proto_hash) {
+	return { { proto_hash.displacements().begin(), proto_hash.displacements().end() },
+		{ proto_hash.values().begin(), proto_hash.values().end() } };
+}
+
+void Serializer::DeserializeStopBuses(ProtoCatalogue& proto_catalogue) {
+	catalogue_.SetStopBuses({ proto_catalogue.stop_buses_offsets().begin(), proto_catalogue.stop_buses_offsets().end() },
+		{ proto_catalogue.stop_buses().begin(), proto_catalogue.stop_buses().end() });
+}
+
+void Serializer::DeserializeStopGrid(ProtoCatalogue& proto_catalogue) {
+	const auto& proto_grid = proto_catalogue.stop_grid();
+	spatial_index::Grid grid;
+
+	grid.min = { proto_grid.min().lat(), proto_grid.min().lng() };
+	grid.cell_height = proto_grid.cell_height();
+	grid.cell_width = proto_grid.cell_width();
+	grid.rows = proto_grid.rows();
+	grid.cols = proto_grid.cols();
+	grid.offsets.assign(proto_grid.offsets().begin(), proto_grid.offsets().end());
+	grid.points.assign(proto_grid.stops().begin(), proto_grid.stops().end());
+
+	catalogue_.SetStopGrid(spatial_index::SpatialIndex(std::move(grid)));
+}
+
+void Serializer::DeserializeNameOrders(ProtoCatalogue& proto_catalogue) {
+	catalogue_.SetNameOrders({ proto_catalogue.buses_by_name().begin(), proto_catalogue.buses_by_name().end() },
+		{ proto_catalogue.stops_by_name().begin(), proto_catalogue.stops_by_name().end() },
+		{ proto_catalogue.served_stops_by_name().begin(), proto_catalogue.served_stops_by_name().end() });
 }
 
 void Serializer::DeserializeRenderSettings(ProtoCatalogue& proto_catalogue) {
@@ -312,7 +652,6 @@ svg::Rgba Serializer::DeserializeRgba(const proto_svg::Rgba& proto_rgba) {
 
 void Serializer::DeserializeTransportRouter(ProtoCatalogue& proto_catalogue) {
 	DeserializeRouterSettings(proto_catalogue);
-	DeserializeStopIdByName(proto_catalogue);
 	DeserializeGraph(proto_catalogue);
 	DeserializeRouter(proto_catalogue);
 }
@@ -327,18 +666,6 @@ void Serializer::DeserializeRouterSettings(ProtoCatalogue& proto_catalogue) {
 	router_.SetRouterSettings(router_settings);
 }
 
-void Serializer::DeserializeStopIdByName(ProtoCatalogue& proto_catalogue) {
-	auto& proto_router = proto_catalogue.router();
-	auto stops_count = proto_router.stop_id_by_name_size();
-
-	for (auto i = 0; i < stops_count; ++i) {
-		auto& proto_stop_id_by_name = proto_router.stop_id_by_name(i);
-		auto stop = catalogue_.GetAllStops().at(proto_stop_id_by_name.name());
-		router_.GetStopsIdByName().insert({ stop->name,
-									proto_stop_id_by_name.id() });
-	}
-}
-
 void Serializer::DeserializeGraph(ProtoCatalogue& proto_catalogue) {
 	auto& proto_graph = proto_catalogue.router().graph();
 	auto edge_count = proto_graph.edges_size();
@@ -405,9 +732,9 @@ transport_router::EdgeWeight
 Serializer::DeserializeEdgeWeight(const proto_graph::EdgeWeight& proto_weight) const {
 	transport_router::EdgeWeight weight;
 
-	weight.bus_name = catalogue_.GetAllBuses().at(proto_weight.bus_name())->name;
-	weight.from = catalogue_.GetAllStops().at(proto_weight.from())->name;
-	weight.to = catalogue_.GetAllStops().at(proto_weight.to())->name;
+	weight.bus = proto_weight.bus();
+	weight.from = proto_weight.from();
+	weight.to = proto_weight.to();
 	weight.span_count = proto_weight.span_count();
 	weight.total_time = proto_weight.total_time();
 
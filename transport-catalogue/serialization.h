@@ -1,7 +1,9 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <filesystem>
+#include <type_traits>
 
 #include "transport_catalogue.h"
 #include "map_renderer.h"
@@ -22,6 +24,9 @@ class Serializer {
 public:
 	using ProtoCatalogue = proto_transport_catalogue::TransportCatalogue;
 
+	// written into every base and bumped whenever the meaning of its fields changes
+	static constexpr uint32_t FORMAT_VERSION = 1;
+
 	Serializer(const SerializerSettings& settings,
 		transport_catalogue::TransportCatalogue& catalogue,
 		map_renderer::MapRenderer& renderer,
@@ -31,9 +36,11 @@ public:
 		, renderer_(renderer)
 		, router_(router) {}
 
-	void Serialize();
+	// false if the base can't be written, the old base file is kept then
+	bool Serialize();
 
-	void Deserialize();
+	// false if the base file can't be read, is of another format version or isn't consistent
+	bool Deserialize();
 
 private:
 	SerializerSettings settings_;
@@ -43,8 +50,15 @@ private:
 	transport_router::TransportRouter& router_;
 
 	void SerializeStops(ProtoCatalogue& proto_catalogue);
+	void SerializeCoordinates(geo::Coordinates coordinates, proto_transport_catalogue::Coordinates& proto_coordinates);
+	void SerializeCoordinates(geo::FixedCoordinates coordinates, proto_transport_catalogue::Coordinates& proto_coordinates);
 	void SerializeDistances(ProtoCatalogue& proto_catalogue);
 	void SerializeBuses(ProtoCatalogue& proto_catalogue);
+	void SerializeNameIndexes(ProtoCatalogue& proto_catalogue);
+	proto_transport_catalogue::PerfectHash SerializePerfectHash(const perfect_hash::PerfectHash& hash);
+	void SerializeStopBuses(ProtoCatalogue& proto_catalogue);
+	void SerializeStopGrid(ProtoCatalogue& proto_catalogue);
+	void SerializeNameOrders(ProtoCatalogue& proto_catalogue);
 
 	void SerializeRenderSettings(ProtoCatalogue& proto_catalogue);
 	proto_svg::Point SerializePoint(const svg::Point& point);
@@ -54,14 +68,31 @@ private:
 
 	void SerializeTransportRouter(ProtoCatalogue& proto_catalogue);
 	void SerializeRouterSettings(ProtoCatalogue& proto_catalogue);
-	void SerializeStopIdByName(ProtoCatalogue& proto_catalogue);
 	void SerializeGraph(ProtoCatalogue& proto_catalogue);
 	void SerializeRouter(ProtoCatalogue& proto_catalogue);
 	proto_graph::EdgeWeight SerializeEdgeWeight(const transport_router::EdgeWeight& weight) const;
 
+	// checks the base before anything is restored from it, so ids and offsets of a corrupt base
+	// can't point past the arrays they index
+	static bool CheckCatalogue(const ProtoCatalogue& proto_catalogue);
+	static bool CheckDistances(const ProtoCatalogue& proto_catalogue);
+	static bool CheckRoutes(const ProtoCatalogue& proto_catalogue);
+	static bool CheckPerfectHash(const proto_transport_catalogue::PerfectHash& proto_hash, size_t id_count);
+	static bool CheckStopBuses(const ProtoCatalogue& proto_catalogue);
+	static bool CheckStopGrid(const ProtoCatalogue& proto_catalogue);
+	static bool CheckNameOrders(const ProtoCatalogue& proto_catalogue);
+	static bool CheckTransportRouter(const ProtoCatalogue& proto_catalogue);
+
+	void ReserveCatalogue(ProtoCatalogue& proto_catalogue);
 	void DeserializeStops(ProtoCatalogue& proto_catalogue);
 	void DeserializeDistances(ProtoCatalogue& proto_catalogue);
-	void DeserializeBuses(ProtoCatalogue& proto_catalogue);
+	// false if a route needs a road distance the base doesn't have
+	bool DeserializeBuses(ProtoCatalogue& proto_catalogue);
+	void DeserializeNameIndexes(ProtoCatalogue& proto_catalogue);
+	perfect_hash::PerfectHash DeserializePerfectHash(const proto_transport_catalogue::PerfectHash& proto_hash);
+	void DeserializeStopBuses(ProtoCatalogue& proto_catalogue);
+	void DeserializeStopGrid(ProtoCatalogue& proto_catalogue);
+	void DeserializeNameOrders(ProtoCatalogue& proto_catalogue);
 
 	void DeserializeRenderSettings(ProtoCatalogue& proto_catalogue);
 	svg::Point DeserializePoint(const proto_svg::Point& proto_point);
@@ -71,7 +102,6 @@ private:
 
 	void DeserializeTransportRouter(ProtoCatalogue& proto_catalogue);
 	void DeserializeRouterSettings(ProtoCatalogue& proto_catalogue);
-	void DeserializeStopIdByName(ProtoCatalogue& proto_catalogue);
 	void DeserializeGraph(ProtoCatalogue& proto_catalogue);
 	void DeserializeRouter(ProtoCatalogue& proto_catalogue);
 	transport_router::EdgeWeight DeserializeEdgeWeight(const proto_graph::EdgeWeight& proto_weight) const;
@@ -0,0 +1,78 @@
+#include <atomic>
+#include <exception>
+
+#include "snapshot.h"
+
+namespace snapshot {
+
+std::shared_ptr<const Snapshot> LoadSnapshot(const serializer::SerializerSettings& settings) {
+	auto res = std::make_shared<Snapshot>();
+	serializer::Serializer serializer(settings, res->catalogue, res->renderer, res->router);
+
+	if (!serializer.Deserialize()) {
+		return nullptr;
+	}
+
+	return res;
+}
+
+std::shared_ptr<const Snapshot> SnapshotHolder::Get() const {
+	return std::atomic_load(&current_);
+}
+
+void SnapshotHolder::Set(std::shared_ptr<const Snapshot> snapshot) {
+	std::atomic_store(&current_, std::move(snapshot));
+}
+
+BaseReloader::BaseReloader(serializer::SerializerSettings settings, SnapshotHolder& holder,
+	std::chrono::milliseconds poll_interval)
+	: settings_(std::move(settings))
+	, holder_(holder)
+	, poll_interval_(poll_interval) {
+	std::error_code error;
+	last_write_time_ = std::filesystem::last_write_time(settings_.path, error);
+	thread_ = std::thread([this] { Watch(); });
+}
+
+BaseReloader::~BaseReloader() {
+	{
+		std::lock_guard lock(mutex_);
+		stopped_ = true;
+	}
+	stop_condition_.notify_all();
+	thread_.join();
+}
+
+bool BaseReloader::Reload() {
+	std::shared_ptr<const Snapshot> snapshot;
+	try {
+		snapshot = LoadSnapshot(settings_);
+	} catch (std::exception&) {
+		// a corrupt or partly written base must not bring the server down
+		return false;
+	}
+	if (!snapshot) {
+		return false;
+	}
+	holder_.Set(std::move(snapshot));
+	return true;
+}
+
+void BaseReloader::Watch() {
+	std::unique_lock lock(mutex_);
+	while (!stop_condition_.wait_for(lock, poll_interval_, [this] { return stopped_; })) {
+		std::error_code error;
+		const auto write_time = std::filesystem::last_write_time(settings_.path, error);
+		if (error || write_time == last_write_time_) {
+			continue;
+		}
+		// a file that can't be read is tried again once it changes
+		last_write_time_ = write_time;
+		// the load takes long, the destructor must not wait for the mutex all that time
+		lock.unlock();
+		Reload();
+		lock.lock();
+	}
+}
+
+} // namespace snapshot
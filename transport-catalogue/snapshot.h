@@ -0,0 +1,85 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "transport_catalogue.h"
+#include "map_renderer.h"
+#include "transport_router.h"
+#include "request_handler.h"
+#include "serialization.h"
+
+namespace snapshot {
+
+// Everything needed to answer stat requests. A snapshot is built once and only read afterwards,
+// so any number of threads may use it at the same time. The handler refers to the other members,
+// so a snapshot is neither copied nor moved
+struct Snapshot {
+	Snapshot() = default;
+	Snapshot(const Snapshot&) = delete;
+	Snapshot& operator=(const Snapshot&) = delete;
+
+	transport_catalogue::TransportCatalogue catalogue;
+	map_renderer::MapRenderer renderer{ map_renderer::RenderSettings{} };
+	transport_router::TransportRouter router{ transport_router::RouterSettings{} };
+	request_handler::RequestHandler handler{ catalogue, renderer, router };
+};
+
+// reads a snapshot from a base file made by Serializer::Serialize(), nullptr if the file can't be read
+std::shared_ptr<const Snapshot> LoadSnapshot(const serializer::SerializerSettings& settings);
+
+// The current snapshot, replaced as a whole (RCU-style). Readers get their own reference
+// and keep using that version until they drop it, a replaced version is freed with its last reader.
+// Get() and Set() are atomic but not lock-free: libstdc++ and MSVC guard atomic operations on
+// a shared_ptr with a small pool of mutexes, held just for copying the pointer and its count.
+// So a reader waits at most for another copy of the pointer, never for a snapshot being loaded
+class SnapshotHolder {
+public:
+	SnapshotHolder() = default;
+
+	explicit SnapshotHolder(std::shared_ptr<const Snapshot> snapshot)
+		: current_(std::move(snapshot)) {}
+
+	std::shared_ptr<const Snapshot> Get() const;
+
+	void Set(std::shared_ptr<const Snapshot> snapshot);
+
+private:
+	std::shared_ptr<const Snapshot> current_;
+};
+
+// Watches the base file from a background thread and loads it into a new snapshot of the holder
+// every time the file is replaced. Requests that already took the old snapshot finish on it
+class BaseReloader {
+public:
+	BaseReloader(serializer::SerializerSettings settings, SnapshotHolder& holder,
+		std::chrono::milliseconds poll_interval = std::chrono::seconds(1));
+
+	BaseReloader(const BaseReloader&) = delete;
+	BaseReloader& operator=(const BaseReloader&) = delete;
+
+	// stops watching, a reload in progress is finished first
+	~BaseReloader();
+
+	// loads the base file right away, the current snapshot is kept if the file can't be read or is corrupt
+	bool Reload();
+
+private:
+	serializer::SerializerSettings settings_;
+	SnapshotHolder& holder_;
+	std::chrono::milliseconds poll_interval_;
+	std::filesystem::file_time_type last_write_time_;
+
+	std::mutex mutex_;
+	std::condition_variable stop_condition_;
+	bool stopped_ = false;
+	std::thread thread_;
+
+	void Watch();
+};
+
+} // namespace snapshot
@@ -0,0 +1,174 @@
+#define _USE_MATH_DEFINES
+#include <algorithm>
+#include <cmath>
+
+#include "spatial_index.h"
+
+namespace spatial_index {
+
+namespace {
+
+const double EARTH_RADIUS = 6371000;
+const double DEGREES_PER_RADIAN = 180.0 / M_PI;
+
+} // namespace
+
+SpatialIndex::SpatialIndex(const std::vector<geo::StoredCoordinates>& points) {
+	if (points.empty()) {
+		return;
+	}
+
+	geo::Coordinates min = geo::ToDouble(points.front());
+	geo::Coordinates max = min;
+	for (const auto point : points) {
+		const auto coordinates = geo::ToDouble(point);
+		min.lat = std::min(min.lat, coordinates.lat);
+		min.lng = std::min(min.lng, coordinates.lng);
+		max.lat = std::max(max.lat, coordinates.lat);
+		max.lng = std::max(max.lng, coordinates.lng);
+	}
+
+	// square cells of about one point each. A cell is never smaller than the longer side of the box
+	// divided by the number of points, so a box that is nearly a line gets about as many cells
+	// as points along it and not a huge number across it. A box degenerated into a point gets one cell
+	const double height = max.lat - min.lat;
+	const double width = max.lng - min.lng;
+	const double count = static_cast<double>(points.size());
+	double cell_size = std::max(std::sqrt(height * width / count), std::max(height, width) / count);
+	if (cell_size == 0.0) {
+		cell_size = 1.0;
+	}
+
+	// rows * cols <= height * width / cell_size^2 + (height + width) / cell_size + 1 <= 3 * count + 1,
+	// cells grow if rounding ever gives more
+	uint64_t rows = 0;
+	uint64_t cols = 0;
+	for (;; cell_size *= 2) {
+		rows = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(height / cell_size)));
+		cols = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(width / cell_size)));
+		if (rows * cols <= 4 * static_cast<uint64_t>(points.size())) {
+			break;
+		}
+	}
+
+	grid_.min = min;
+	grid_.cell_height = cell_size;
+	grid_.cell_width = cell_size;
+	grid_.rows = static_cast<uint32_t>(rows);
+	grid_.cols = static_cast<uint32_t>(cols);
+
+	// counting sort of points by cell
+	std::vector<uint32_t> cells(points.size());
+	grid_.offsets.assign(static_cast<size_t>(grid_.rows) * grid_.cols + 1, 0);
+	for (size_t i = 0; i < points.size(); ++i) {
+		const auto coordinates = geo::ToDouble(points[i]);
+		cells[i] = GetRow(coordinates.lat) * grid_.cols + GetCol(coordinates.lng);
+		++grid_.offsets[cells[i] + 1];
+	}
+	for (size_t i = 1; i < grid_.offsets.size(); ++i) {
+		grid_.offsets[i] += grid_.offsets[i - 1];
+	}
+
+	grid_.points.resize(points.size());
+	std::vector<uint32_t> next(grid_.offsets.begin(), grid_.offsets.end() - 1);
+	for (size_t i = 0; i < points.size(); ++i) {
+		grid_.points[next[cells[i]]++] = static_cast<uint32_t>(i);
+	}
+}
+
+const Grid& SpatialIndex::GetGrid() const {
+	return grid_;
+}
+
+std::vector<Neighbor> SpatialIndex::FindWithinRadius(const std::vector<geo::StoredCoordinates>& points,
+	geo::Coordinates center, double radius) const {
+	std::vector<Neighbor> result;
+	if (grid_.rows == 0 || !(radius >= 0.0)) {
+		return result;
+	}
+
+	// bounding box of the spherical cap around the center
+	const double angle = radius / EARTH_RADIUS;
+	const double lat_delta = angle * DEGREES_PER_RADIAN;
+	const double min_lat = center.lat - lat_delta;
+	const double max_lat = center.lat + lat_delta;
+	if (max_lat < grid_.min.lat || min_lat > grid_.min.lat + grid_.rows * grid_.cell_height) {
+		return result;
+	}
+
+	const uint32_t first_row = GetRow(min_lat);
+	const uint32_t last_row = GetRow(max_lat);
+	if (angle >= M_PI / 2 || min_lat <= -90.0 || max_lat >= 90.0) {
+		// the cap contains a pole or a half of the sphere, so every longitude is inside
+		CollectCells(points, center, radius, first_row, last_row, grid_.min.lng, grid_.min.lng + grid_.cols * grid_.cell_width, result);
+	} else {
+		const double lng_delta = std::asin(std::sin(angle) / std::cos(center.lat / DEGREES_PER_RADIAN)) * DEGREES_PER_RADIAN;
+		// the longitude interval may wrap around the antimeridian
+		for (const double shift : { 0.0, -360.0, 360.0 }) {
+			CollectCells(points, center, radius, first_row, last_row,
+				center.lng - lng_delta + shift, center.lng + lng_delta + shift, result);
+		}
+	}
+
+	std::sort(result.begin(), result.end(), [](const Neighbor& lhs, const Neighbor& rhs) {
+		return lhs.distance < rhs.distance || (lhs.distance == rhs.distance && lhs.id < rhs.id);
+	});
+	return result;
+}
+
+std::vector<Neighbor> SpatialIndex::FindNearest(const std::vector<geo::StoredCoordinates>& points,
+	geo::Coordinates center, size_t count, double radius) const {
+	if (grid_.rows == 0 || count == 0) {
+		return {};
+	}
+
+	// the search radius starts at a few cells and doubles until enough points are found,
+	// half of the equator covers the whole sphere
+	const double max_radius = std::min(radius, M_PI * EARTH_RADIUS);
+	double search_radius = std::min(max_radius,
+		std::max(grid_.cell_height, grid_.cell_width) / DEGREES_PER_RADIAN * EARTH_RADIUS * std::sqrt(static_cast<double>(count)));
+	for (;;) {
+		auto result = FindWithinRadius(points, center, search_radius);
+		if (result.size() >= count || search_radius >= max_radius) {
+			if (result.size() > count) {
+				result.resize(count);
+			}
+			return result;
+		}
+		search_radius = std::min(max_radius, search_radius * 2);
+	}
+}
+
+uint32_t SpatialIndex::GetRow(double lat) const {
+	const double row = std::floor((lat - grid_.min.lat) / grid_.cell_height);
+	return static_cast<uint32_t>(std::clamp(row, 0.0, static_cast<double>(grid_.rows - 1)));
+}
+
+uint32_t SpatialIndex::GetCol(double lng) const {
+	const double col = std::floor((lng - grid_.min.lng) / grid_.cell_width);
+	return static_cast<uint32_t>(std::clamp(col, 0.0, static_cast<double>(grid_.cols - 1)));
+}
+
+void SpatialIndex::CollectCells(const std::vector<geo::StoredCoordinates>& points, geo::Coordinates center, double radius,
+	uint32_t first_row, uint32_t last_row, double min_lng, double max_lng, std::vector<Neighbor>& result) const {
+	if (max_lng < grid_.min.lng || min_lng > grid_.min.lng + grid_.cols * grid_.cell_width) {
+		return;
+	}
+	const uint32_t first_col = GetCol(min_lng);
+	const uint32_t last_col = GetCol(max_lng);
+
+	for (uint32_t row = first_row; row <= last_row; ++row) {
+		// cells of a row are adjacent in the points array
+		const uint32_t begin = grid_.offsets[row * grid_.cols + first_col];
+		const uint32_t end = grid_.offsets[row * grid_.cols + last_col + 1];
+		for (uint32_t i = begin; i < end; ++i) {
+			const uint32_t id = grid_.points[i];
+			const double distance = geo::ComputeDistance(center, geo::ToDouble(points[id]));
+			if (distance <= radius) {
+				result.push_back({ id, distance });
+			}
+		}
+	}
+}
+
+} // namespace spatial_index
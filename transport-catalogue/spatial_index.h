@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "geo.h"
+
+namespace spatial_index {
+
+// uniform grid of latitude/longitude cells over the bounding box of the points,
+// points of cell (row, col) are points[offsets[row * cols + col]] .. points[offsets[row * cols + col + 1] - 1]
+struct Grid {
+	geo::Coordinates min{ 0.0, 0.0 };
+	double cell_height = 0.0;
+	double cell_width = 0.0;
+	uint32_t rows = 0;
+	uint32_t cols = 0;
+	std::vector<uint32_t> offsets;
+	std::vector<uint32_t> points;
+};
+
+struct Neighbor {
+	uint32_t id = 0;
+	double distance = 0.0;
+};
+
+// Spatial index over a fixed set of points, which are addressed by their indices.
+// The index doesn't keep coordinates, queries take the same points it was built over
+class SpatialIndex {
+public:
+	SpatialIndex() = default;
+
+	// about one point per cell
+	explicit SpatialIndex(const std::vector<geo::StoredCoordinates>& points);
+
+	explicit SpatialIndex(Grid grid)
+		: grid_(std::move(grid)) {}
+
+	const Grid& GetGrid() const;
+
+	// points not farther than radius meters from center, nearest first
+	std::vector<Neighbor> FindWithinRadius(const std::vector<geo::StoredCoordinates>& points,
+		geo::Coordinates center, double radius) const;
+
+	// at most count points nearest to center, not farther than radius meters
+	std::vector<Neighbor> FindNearest(const std::vector<geo::StoredCoordinates>& points,
+		geo::Coordinates center, size_t count, double radius = std::numeric_limits<double>::infinity()) const;
+
+private:
+	Grid grid_;
+
+	uint32_t GetRow(double lat) const;
+	uint32_t GetCol(double lng) const;
+
+	void CollectCells(const std::vector<geo::StoredCoordinates>& points, geo::Coordinates center, double radius,
+		uint32_t first_row, uint32_t last_row, double min_lng, double max_lng, std::vector<Neighbor>& result) const;
+};
+
+} // namespace spatial_index
@@ -0,0 +1,46 @@
+#include <algorithm>
+#include <cstring>
+
+#include "string_arena.h"
+
+namespace string_arena {
+
+std::string_view StringArena::Add(std::string_view str) {
+	if (blocks_.empty() || blocks_.back().capacity - blocks_.back().size < str.size()) {
+		// a string longer than a block gets a block of its own
+		const size_t capacity = std::max(block_size_, str.size());
+		blocks_.push_back({ std::make_unique<char[]>(capacity), 0, capacity });
+	}
+
+	auto& block = blocks_.back();
+	char* dest = block.data.get() + block.size;
+	std::memcpy(dest, str.data(), str.size());
+	block.size += str.size();
+
+	return { dest, str.size() };
+}
+
+void StringArena::Reserve(size_t bytes) {
+	if (blocks_.empty() || blocks_.back().capacity - blocks_.back().size < bytes) {
+		const size_t capacity = std::max(block_size_, bytes);
+		blocks_.push_back({ std::make_unique<char[]>(capacity), 0, capacity });
+	}
+}
+
+size_t StringArena::GetUsedSize() const {
+	size_t res = 0;
+	for (const auto& block : blocks_) {
+		res += block.size;
+	}
+	return res;
+}
+
+size_t StringArena::GetCapacity() const {
+	size_t res = 0;
+	for (const auto& block : blocks_) {
+		res += block.capacity;
+	}
+	return res;
+}
+
+} // namespace string_arena
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace string_arena {
+
+// Append-only storage for strings. Strings are packed one after another into big blocks,
+// which are never reallocated, so views of added strings stay valid as long as the arena lives
+class StringArena {
+public:
+	explicit StringArena(size_t block_size = 64 * 1024)
+		: block_size_(block_size) {}
+
+	std::string_view Add(std::string_view str);
+
+	// makes the next bytes bytes of strings fit into one block
+	void Reserve(size_t bytes);
+
+	// bytes taken by strings and reserved for them
+	size_t GetUsedSize() const;
+	size_t GetCapacity() const;
+
+private:
+	struct Block {
+		std::unique_ptr<char[]> data;
+		size_t size = 0;
+		size_t capacity = 0;
+	};
+
+	size_t block_size_;
+	std::vector<Block> blocks_;
+};
+
+} // namespace string_arena
\ No newline at end of file
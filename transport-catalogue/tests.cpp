@@ -1,19 +1,148 @@
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <new>
 #include <string>
+#include <thread>
+#include <vector>
 #include <iostream>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <sstream>
 
 #include "tests.h"
+#include "geo.h"
 #include "transport_catalogue.h"
+#include "transport_router.h"
+#include "map_renderer.h"
+#include "request_handler.h"
+#include "json.h"
+#include "json_reader.h"
+#include "snapshot.h"
+
+namespace {
+
+// every heap allocation of the test binary is counted, Freeze() allocates from worker threads too
+std::atomic<size_t> allocation_count = 0;
+
+void* Allocate(std::size_t size, std::size_t alignment) {
+	++allocation_count;
+	size = size == 0 ? 1 : size;
+	void* ptr = nullptr;
+	if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+		ptr = std::malloc(size);
+	} else {
+#ifdef _MSC_VER
+		ptr = _aligned_malloc(size, alignment);
+#else
+		// the size of aligned_alloc must be a multiple of the alignment
+		ptr = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+	}
+	if (!ptr) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+// kept out of line, so GCC doesn't take free() inlined into a caller of delete for a mismatch with new
+#if defined(__GNUC__)
+__attribute__((noinline))
+#endif
+void Free(void* ptr, [[maybe_unused]] std::size_t alignment) noexcept {
+#ifdef _MSC_VER
+	if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+		_aligned_free(ptr);
+		return;
+	}
+#endif
+	std::free(ptr);
+}
+
+} // namespace
+
+// all forms are replaced together, so each block is freed by the allocator it came from
+
+void* operator new(std::size_t size) {
+	return Allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void* operator new[](std::size_t size) {
+	return Allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+	return Allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+	return Allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+	try {
+		return Allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+	} catch (std::bad_alloc&) {
+		return nullptr;
+	}
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+	try {
+		return Allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+	} catch (std::bad_alloc&) {
+		return nullptr;
+	}
+}
+
+void operator delete(void* ptr) noexcept {
+	Free(ptr, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void operator delete[](void* ptr) noexcept {
+	Free(ptr, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+	Free(ptr, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+	Free(ptr, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void operator delete(void* ptr, std::align_val_t alignment) noexcept {
+	Free(ptr, static_cast<std::size_t>(alignment));
+}
+
+void operator delete[](void* ptr, std::align_val_t alignment) noexcept {
+	Free(ptr, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t alignment) noexcept {
+	Free(ptr, static_cast<std::size_t>(alignment));
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t alignment) noexcept {
+	Free(ptr, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+	Free(ptr, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+	Free(ptr, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
 
 namespace transport_catalogue::tests {
 
-void TestTransportCatalogue() {
-	using namespace transport_catalogue;
+namespace {
 
-	TransportCatalogue catalog;
+void FillCatalogue(TransportCatalogue& catalog) {
 	catalog.AddStop("Tolstopaltsevo", { 55.611087, 37.208290 });
 	catalog.AddStop("Marushkino", { 55.595884, 37.209755 });
 	catalog.AddStop("Rasskazovka", { 55.632761, 37.333324 });
@@ -41,6 +170,16 @@ void TestTransportCatalogue() {
 	catalog.AddBus("256", { "Biryulyovo Zapadnoye", "Biryusinka", "Universam", "Biryulyovo Tovarnaya", "Biryulyovo Passazhirskaya", "Biryulyovo Zapadnoye" }, true);
 	catalog.AddBus("750", { "Tolstopaltsevo", "Marushkino", "Marushkino", "Rasskazovka" }, false);
 	catalog.AddBus("828", { "Biryulyovo Zapadnoye", "Universam", "Rossoshanskaya ulitsa", "Biryulyovo Zapadnoye" }, true);
+	catalog.Freeze();
+}
+
+} // namespace
+
+void TestTransportCatalogue() {
+	using namespace transport_catalogue;
+
+	TransportCatalogue catalog;
+	FillCatalogue(catalog);
 
 	auto res = catalog.GetBusInfo("256");
 
@@ -58,6 +197,11 @@ void TestTransportCatalogue() {
 	assert(res.length == 27400);
 	assert(std::abs(res.curvature - 1.30853) < 1e-5);
 
+	assert(catalog.FindBusStat("751") == std::nullopt);
+	assert(catalog.FindBusStat("750")->length == 27400);
+	assert(catalog.FindBusesAtStop("Samara") == std::nullopt);
+	assert(catalog.FindBusesAtStop("Biryulyovo Zapadnoye")->size() == 2);
+
 	try {
 		const auto buses_at_stop = catalog.GetBusesAtStop("Samara");
 	} catch (std::out_of_range& e) {
@@ -72,24 +216,305 @@ void TestTransportCatalogue() {
 	{
 		const auto buses_at_stop = catalog.GetBusesAtStop("Biryulyovo Zapadnoye");
 		assert(buses_at_stop.size() == 2);
-		assert(*buses_at_stop.cbegin() == "256");
+		assert(catalog.GetBusName(*buses_at_stop.begin()) == "256");
+	}
+
+	{
+		// a name given to two buses is listed once, as the bus it's looked up to
+		TransportCatalogue same_names;
+		same_names.AddStop("A", { 55.6, 37.2 });
+		same_names.AddStop("B", { 55.61, 37.2 });
+		same_names.AddStop("C", { 55.62, 37.2 });
+		same_names.SetDistance("A", "B", 1000);
+		same_names.SetDistance("C", "A", 500);
+		same_names.AddBus("1", { "C", "A", "B" }, false);
+		same_names.AddBus("2", { "A", "B" }, false);
+		same_names.AddBus("1", { "B", "A", "B" }, false);
+		same_names.Freeze();
+
+		const auto buses_at_stop = same_names.GetBusesAtStop("A");
+		assert(buses_at_stop.size() == 2);
+		assert(*buses_at_stop.begin() == same_names.GetBusId("1"));
+		assert(same_names.GetBusName(*(buses_at_stop.begin() + 1)) == "2");
+		// the bus of that name doesn't pass C any longer
+		assert(same_names.GetBusesAtStop("C").size() == 0);
 	}
 
 	std::cout << __FUNCTION__ << " OK" << std::endl;
 }
 
+void TestAllocationFreeLookups() {
+	using namespace transport_catalogue;
+
+	TransportCatalogue catalog;
+	FillCatalogue(catalog);
+	map_renderer::MapRenderer renderer;
+	transport_router::TransportRouter router({ 6, 40.0 });
+	router.InitializeRouterWithCatalogue(catalog);
+	request_handler::RequestHandler handler(catalog, renderer, router);
+
+	const std::string bus = "256", unknown_bus = "257";
+	const std::string stop = "Biryulyovo Zapadnoye", unknown_stop = "Samara";
+	const std::string from = "Biryusinka", to = "Biryulyovo Passazhirskaya";
+
+	// the route buffer grows on the first request only
+	request_handler::RequestHandler::Route route;
+	assert(handler.BuildRoute(from, to, route));
+	const size_t route_size = route.route.size();
+
+	const size_t allocations_before = allocation_count;
+
+	assert(handler.GetBusStat(bus)->stops == 6);
+	assert(!handler.GetBusStat(unknown_bus));
+	assert(handler.GetBusesByStop(stop)->size() == 2);
+	assert(!handler.GetBusesByStop(unknown_stop));
+	assert(handler.BuildRoute(from, to, route) && route.route.size() == route_size);
+	assert(!handler.BuildRoute(from, unknown_stop, route));
+
+	assert(allocation_count == allocations_before);
+
+	std::cout << __FUNCTION__ << " OK" << std::endl;
+}
+
 void TestJSONReader() {
+	using namespace std::literals;
+
+	// B is read before A, so its distance to A waits till the end of base requests,
+	// while the bus is read after both stops and must count it all the same
+	const auto load = [](std::string_view a_distances) {
+		const std::string input = R"({"base_requests": [
+			{"type": "Stop", "name": "B", "latitude": 55.61, "longitude": 37.2, "road_distances": {"A": 200}},
+			{"type": "Stop", "name": "A", "latitude": 55.6, "longitude": 37.2, "road_distances": )"s
+			+ std::string(a_distances) + R"(},
+			{"type": "Bus", "name": "1", "stops": ["A", "B"], "is_roundtrip": false}]})"s;
+		TransportCatalogue catalog;
+		json_reader::JSONReader reader(input, catalog);
+		catalog.Freeze();
+		return catalog.FindBusStat("1"sv).value().length;
+	};
+
+	assert(load(R"({"B": 100})"sv) == 300);
+	// without a distance from A to B the distance from B to A is taken back
+	assert(load("{}"sv) == 400);
+
+	std::cout << __FUNCTION__ << " OK" << std::endl;
+}
+
+void TestNearbyStops() {
+	const double infinity = std::numeric_limits<double>::infinity();
+
+	TransportCatalogue catalog;
+	catalog.AddStop("A", { 55.0, 37.0 });
+	catalog.AddStop("B", { 55.001, 37.0 });
+	catalog.AddStop("C", { 55.002, 37.0 });
+	catalog.AddStop("D", { 55.01, 37.0 });
+	// both sides of the antimeridian
+	catalog.AddStop("E", { 0.0, 179.9999 });
+	catalog.AddStop("F", { 0.0, -179.9999 });
+	catalog.AddStop("G", { 0.0, 179.0 });
+	catalog.Freeze();
+
+	const geo::Coordinates center{ 55.0, 37.0 };
+	auto nearby = catalog.FindNearbyStops(center, 250.0, 10);
+	assert(nearby.size() == 3);
+	assert(nearby[0].id == 0 && nearby[0].distance == 0.0);
+	assert(nearby[1].id == 1 && nearby[2].id == 2);
+	assert(nearby[1].distance == geo::ComputeDistance(center, { 55.001, 37.0 }));
+
+	// the count limits the nearest stops of any distance
+	nearby = catalog.FindNearbyStops({ 55.0105, 37.0 }, infinity, 2);
+	assert(nearby.size() == 2 && nearby[0].id == 3 && nearby[1].id == 2);
+
+	nearby = catalog.FindNearbyStops({ 0.0, 180.0 }, 50.0, 10);
+	assert(nearby.size() == 2 && nearby[0].id == 4 && nearby[1].id == 5);
+	nearby = catalog.FindNearbyStops({ 0.0, -179.99995 }, 50.0, 10);
+	assert(nearby.size() == 2 && nearby[0].id == 5 && nearby[1].id == 4);
+
+	TransportCatalogue empty;
+	empty.Freeze();
+	assert(empty.FindNearbyStops(center, infinity, 10).empty());
+
+	// a box that is nearly a line gets about one cell per stop along it
+	for (const double span : { 1e-13, 1e-300 }) {
+		TransportCatalogue line;
+		for (int i = 0; i < 4; ++i) {
+			line.AddStop(std::to_string(i), { 55.0 + i * span, 37.0 + i * 0.1 });
+		}
+		line.Freeze();
+
+		const auto& grid = line.GetStopGrid().GetGrid();
+		assert(static_cast<size_t>(grid.rows) * grid.cols <= 3 * 4 + 1);
+		nearby = line.FindNearbyStops({ 55.0, 37.21 }, infinity, 1);
+		assert(nearby.size() == 1 && nearby[0].id == 2);
+	}
+
+	std::cout << __FUNCTION__ << " OK" << std::endl;
+}
+
+void TestFindSpecialChar() {
+	using namespace std::literals;
+
+	// every position of a string longer than two AVX2 blocks, so a special character lands
+	// at both ends of SSE2 and AVX2 blocks (offsets 15, 16, 31, 32) and in the scalar tail
+	for (size_t size = 0; size <= 70; ++size) {
+		std::string str(size, 'a');
+		assert(json::FindSpecialChar(str.data(), str.data() + size) == str.data() + size);
+
+		for (size_t pos = 0; pos < size; ++pos) {
+			for (const char c : "\"\\\n\r"sv) {
+				str[pos] = c;
+				// non-ASCII bytes before it aren't taken for special characters
+				if (pos > 0) {
+					str[pos - 1] = '\xA2';
+				}
+				assert(json::FindSpecialChar(str.data(), str.data() + size) == str.data() + pos);
+
+				std::string escaped;
+				json::WriteEscaped(str, escaped);
+				const std::string expected = '"' + str.substr(0, pos)
+					+ (c == '\n' ? "\\n"s : c == '\r' ? "\\r"s : "\\"s + c) + str.substr(pos + 1) + '"';
+				assert(escaped == expected);
 
+				str.assign(size, 'a');
+			}
+		}
+	}
+
+	std::cout << __FUNCTION__ << " OK" << std::endl;
+}
+
+void TestSphereDistances() {
+	// stops of a city, cities far apart, the poles and both sides of the antimeridian
+	const std::vector<geo::Coordinates> coordinates = {
+		{ 55.611087, 37.208290 }, { 55.595884, 37.209755 }, { 55.632761, 37.333324 }, { 55.574371, 37.651700 },
+		{ 55.581065, 37.648390 }, { 55.587655, 37.645687 }, { 59.93863, 30.31413 }, { -33.86785, 151.20732 },
+		{ 40.71427, -74.00597 }, { 0.0, 0.0 }, { 0.0, 90.0 }, { 89.9, 10.0 }, { -90.0, 0.0 },
+		{ 10.0, 179.99 }, { 10.0, -179.99 }
+	};
+	geo::SpherePoints points;
+	for (const auto point : coordinates) {
+		points.Add(point);
+	}
+
+	// every pair, the same point included
+	std::vector<uint32_t> from;
+	std::vector<uint32_t> to;
+	for (uint32_t i = 0; i < coordinates.size(); ++i) {
+		for (uint32_t j = 0; j < coordinates.size(); ++j) {
+			from.push_back(i);
+			to.push_back(j);
+		}
+	}
+
+	// odd and even counts, so pairs go through both the two-lane loop and the scalar tail
+	std::vector<double> distances(from.size());
+	for (const size_t count : { size_t{ 1 }, size_t{ 2 }, from.size() - 1, from.size() }) {
+		points.ComputeDistances(from.data(), to.data(), count, distances.data());
+		for (size_t i = 0; i < count; ++i) {
+			const double expected = geo::ComputeDistance(coordinates[from[i]], coordinates[to[i]]);
+			assert(std::abs(distances[i] - expected) <= 1e-6 * expected);
+		}
+	}
+
+	std::cout << __FUNCTION__ << " OK" << std::endl;
+}
+
+void TestSnapshotHolder() {
+	// snapshots with more and more stops, so a reader sees versions only in the order they were set
+	const auto make_snapshot = [](int stop_count) {
+		auto snapshot = std::make_shared<snapshot::Snapshot>();
+		for (int i = 0; i < stop_count; ++i) {
+			snapshot->catalogue.AddStop(std::to_string(i), { 55.0, 37.0 });
+		}
+		return std::shared_ptr<const snapshot::Snapshot>(std::move(snapshot));
+	};
+
+	const int version_count = 200;
+	std::vector<std::shared_ptr<const snapshot::Snapshot>> versions;
+	for (int i = 0; i < version_count; ++i) {
+		versions.push_back(make_snapshot(i));
+	}
+
+	snapshot::SnapshotHolder holder(versions.front());
+	std::atomic<bool> done = false;
+	std::vector<std::thread> readers;
+	for (int i = 0; i < 4; ++i) {
+		readers.emplace_back([&holder, &done] {
+			size_t last_count = 0;
+			while (!done) {
+				const auto current = holder.Get();
+				assert(current && current->catalogue.GetStopCount() >= last_count);
+				last_count = current->catalogue.GetStopCount();
+			}
+		});
+	}
+	// the holder keeps the only reference to a replaced version
+	for (auto& version : versions) {
+		holder.Set(std::move(version));
+	}
+	done = true;
+	for (auto& reader : readers) {
+		reader.join();
+	}
+	assert(holder.Get()->catalogue.GetStopCount() == version_count - 1);
 
 	std::cout << __FUNCTION__ << " OK" << std::endl;
 }
 
 void TestAll() {
+	TestTransportCatalogue();
+	TestAllocationFreeLookups();
+	TestJSONReader();
+	TestNearbyStops();
+	TestFindSpecialChar();
+	TestSphereDistances();
+	TestSnapshotHolder();
+	BenchmarkNotFoundLookups();
+
+	std::cout << __FUNCTION__ << " OK" << std::endl;
+}
+
+void BenchmarkNotFoundLookups() {
 	using namespace transport_catalogue;
 
+	const int count = 1000;
 	TransportCatalogue catalog;
+	for (int i = 0; i < count; ++i) {
+		catalog.AddStop("Stop " + std::to_string(i), { 55.0 + i * 1e-4, 37.0 + i * 1e-4 });
+	}
+	for (int i = 0; i + 1 < count; ++i) {
+		catalog.SetDistance("Stop " + std::to_string(i), "Stop " + std::to_string(i + 1), 100);
+		catalog.AddBus("Bus " + std::to_string(i), { "Stop " + std::to_string(i), "Stop " + std::to_string(i + 1) }, false);
+	}
+	catalog.Freeze();
 
-	std::cout << __FUNCTION__ << " OK" << std::endl;
+	std::vector<std::string> names;
+	for (int i = 0; i < 100000; ++i) {
+		names.push_back((i % 12 == 0 ? "Stale bus " : "Bus ") + std::to_string(i % (count - 1)));
+	}
+
+	using Clock = std::chrono::steady_clock;
+	int found_with_exceptions = 0;
+	const auto start_exceptions = Clock::now();
+	for (const auto& name : names) {
+		try {
+			found_with_exceptions += catalog.GetBusInfo(name).stops;
+		} catch (std::out_of_range&) {
+		}
+	}
+	const auto start_optional = Clock::now();
+	int found_with_optional = 0;
+	for (const auto& name : names) {
+		if (const auto stat = catalog.FindBusStat(name)) {
+			found_with_optional += stat->stops;
+		}
+	}
+	const auto finish = Clock::now();
+
+	assert(found_with_exceptions == found_with_optional);
+	std::cout << __FUNCTION__ << ": exceptions "
+		<< std::chrono::duration_cast<std::chrono::microseconds>(start_optional - start_exceptions).count() << " us, optional "
+		<< std::chrono::duration_cast<std::chrono::microseconds>(finish - start_optional).count() << " us" << std::endl;
 }
 
 } // tests
\ No newline at end of file
@@ -4,8 +4,27 @@ namespace transport_catalogue::tests {
 
 void TestTransportCatalogue();
 
+// Bus, Stop and Route lookups don't touch the heap
+void TestAllocationFreeLookups();
+
 void TestJSONReader();
 
+// radius and count limits, the antimeridian, no stops and stops nearly on a line
+void TestNearbyStops();
+
+// special characters at the ends of SIMD blocks and in the tail after them
+void TestFindSpecialChar();
+
+// distances of a batch agree with ComputeDistance() within 1e-6 of their length
+void TestSphereDistances();
+
+// readers take snapshots while another thread keeps replacing them
+void TestSnapshotHolder();
+
+// runs all the tests and the benchmark
 void TestAll();
 
+// lookups of a workload where every 12th name is unknown, with exceptions and without them
+void BenchmarkNotFoundLookups();
+
 } // tests
\ No newline at end of file
@@ -1,113 +1,493 @@
+#include <algorithm>
+#include <numeric>
 #include <stdexcept>
-#include <unordered_set>
 
 #include "transport_catalogue.h"
+#include "parallel.h"
 
 namespace transport_catalogue {
 
-void TransportCatalogue::AddStop(const std::string& name, geo::Coordinates coordinates) {
-	stops_.push_back({ name, coordinates });
-	name_to_stop_[stops_.back().name] = &stops_.back();
-	buses_at_stop_[stops_.back().name];
+void TransportCatalogue::Reserve(const CatalogueSizes& sizes) {
+	names_.Reserve(sizes.name_bytes);
+
+	stop_names_.reserve(sizes.stops);
+	stop_coordinates_.reserve(sizes.stops);
+	bus_names_.reserve(sizes.buses);
+	buses_.reserve(sizes.buses);
+	route_pool_.reserve(sizes.route_stops);
+	forward_distances_pool_.reserve(sizes.route_stops);
+	backward_distances_pool_.reserve(sizes.route_stops);
+
+	if (stop_index_.IsEmpty()) {
+		stop_id_by_name_.reserve(sizes.stops);
+	}
+	if (bus_index_.IsEmpty()) {
+		bus_id_by_name_.reserve(sizes.buses);
+	}
+}
+
+void TransportCatalogue::Freeze() {
+	stop_index_ = perfect_hash::PerfectHash({ stop_id_by_name_.begin(), stop_id_by_name_.end() });
+	bus_index_ = perfect_hash::PerfectHash({ bus_id_by_name_.begin(), bus_id_by_name_.end() });
+
+	stop_id_by_name_ = {};
+	bus_id_by_name_ = {};
+
+	BuildRoadDistances();
+	BuildNameOrders();
+	BuildStopBuses();
+	BuildServedStops();
+	stop_grid_ = spatial_index::SpatialIndex(stop_coordinates_);
+
+	geo::SpherePoints points;
+	points.Reserve(stop_coordinates_.size());
+	for (const auto coordinates : stop_coordinates_) {
+		points.Add(geo::ToDouble(coordinates));
+	}
+
+	// every road distance is known only now, so cumulative distances of routes are filled here
+	bus_stats_.resize(buses_.size());
+	parallel::ForEachChunk(buses_.size(), parallel::GetChunkCount(buses_.size()), [this, &points](size_t, size_t begin, size_t end) {
+		std::vector<double> distances;
+		for (size_t id = begin; id < end; ++id) {
+			FillRouteDistances(buses_[id]);
+			bus_stats_[id] = ComputeBusStat(static_cast<domain::BusId>(id), points, distances);
+		}
+	});
+}
+
+domain::StopId TransportCatalogue::AddStop(std::string_view name, geo::Coordinates coordinates) {
+	const auto id = static_cast<domain::StopId>(stop_names_.size());
+
+	stop_names_.push_back(names_.Add(name));
+	stop_coordinates_.push_back(geo::ToStored(coordinates));
+	if (stop_index_.IsEmpty()) {
+		stop_id_by_name_[stop_names_.back()] = id;
+	}
+
+	return id;
 }
 
-void TransportCatalogue::AddBus(const std::string& name, const std::vector<std::string>& stops, bool ring_route) {
+domain::BusId TransportCatalogue::AddBus(std::string_view name, const std::vector<std::string_view>& stops, bool ring_route) {
+	// stop ids go straight to the route pool, a route with an unknown stop is dropped from it
+	const size_t route_offset = route_pool_.size();
+	for (const auto& stop : stops) {
+		const auto id = FindStopId(stop);
+		if (!id) {
+			route_pool_.resize(route_offset);
+			throw std::out_of_range("Stop " + std::string(stop) + ": not found");
+		}
+		route_pool_.push_back(*id);
+	}
+	return AddBusRoute(name, route_offset, ring_route);
+}
+
+domain::BusId TransportCatalogue::AddBus(std::string_view name, RouteRange stops, bool ring_route) {
+	const size_t route_offset = route_pool_.size();
+	route_pool_.insert(route_pool_.end(), stops.begin(), stops.end());
+	return AddBusRoute(name, route_offset, ring_route);
+}
+
+domain::BusId TransportCatalogue::AddBusRoute(std::string_view name, size_t route_offset, bool ring_route) {
+	const auto id = static_cast<domain::BusId>(buses_.size());
+
 	domain::Bus bus;
-	bus.name = name;
+	bus.route_offset = static_cast<uint32_t>(route_offset);
+	bus.route_size = static_cast<uint32_t>(route_pool_.size() - route_offset);
 	bus.ring_route = ring_route;
 
-	for (const auto& stop : stops) {
-		bus.route.push_back(&GetStop(stop));
+	// distance pools are kept parallel to the route pool, backward distances of ring routes stay zero
+	forward_distances_pool_.resize(route_pool_.size(), 0);
+	backward_distances_pool_.resize(route_pool_.size(), 0);
+	// road distances restored by SetRoadDistances() are final, otherwise Freeze() fills the distances
+	if (!road_distances_.offsets.empty()) {
+		FillRouteDistances(bus);
 	}
+
+	bus_names_.push_back(names_.Add(name));
 	buses_.push_back(std::move(bus));
-	name_to_bus_[buses_.back().name] = &buses_.back();
+	if (bus_index_.IsEmpty()) {
+		bus_id_by_name_[bus_names_.back()] = id;
+	}
 
-	for (const auto& stop : stops) {
-		buses_at_stop_[name_to_stop_.at(stop)->name].insert(buses_.back().name);
+	return id;
+}
+
+const domain::BusStat TransportCatalogue::GetBusInfo(std::string_view name) const {
+	return bus_stats_[GetBusId(name)];
+}
+
+std::optional<domain::BusStat> TransportCatalogue::FindBusStat(std::string_view name) const {
+	if (const auto id = FindBusId(name)) {
+		return bus_stats_[*id];
 	}
+	return std::nullopt;
 }
 
-const domain::BusStat TransportCatalogue::GetBusInfo(const std::string& name) const {
-	const auto& bus = GetBus(name);
-	const std::string_view bus_name = bus.name;
-	int stops_count = static_cast<int>(bus.route.size());
+domain::BusStat TransportCatalogue::ComputeBusStat(domain::BusId bus_id, const geo::SpherePoints& points,
+	std::vector<double>& distances) const {
+	const auto& bus = buses_[bus_id];
+	const auto route = GetRoute(bus_id);
+	const std::string_view bus_name = bus_names_[bus_id];
+	int stops_count = static_cast<int>(route.size());
 	int unic_stops = 0;
 	double route_length_straight = 0.0;
-	int route_length = 0;
-	const domain::Stop* pre_stop = nullptr;
-	std::unordered_set<std::string_view> tmp;
-
-	for (const auto& stop : bus.route) {
-		tmp.insert(stop->name);
-		if (pre_stop) {
-			route_length_straight += ComputeDistance(pre_stop->coordinates, stop->coordinates);
-			route_length += GetDistance(pre_stop->name, stop->name);
+	int route_length = route.empty() ? 0 : GetForwardDistances(bus_id).back();
+	std::vector<domain::StopId> tmp(route.begin(), route.end());
+
+	if (route.size() > 1) {
+		// distances of all segments in one batch
+		distances.resize(route.size() - 1);
+		points.ComputeDistances(route.begin(), route.begin() + 1, distances.size(), distances.data());
+		for (const double distance : distances) {
+			route_length_straight += distance;
 		}
-		pre_stop = stop;
 	}
 	if (bus.ring_route == false) {
 		route_length_straight *= 2;
 		stops_count = 2 * stops_count - 1;
-		for (auto it_from = bus.route.rbegin(), it_to = it_from + 1; it_to < bus.route.rend(); ++it_to, ++it_from) { // count backward distance
-			route_length += GetDistance((*it_from)->name, (*it_to)->name);
+		if (!route.empty()) {
+			route_length += GetBackwardDistances(bus_id).back();
 		}
 	}
-	unic_stops = static_cast<int>(tmp.size());
+	std::sort(tmp.begin(), tmp.end());
+	unic_stops = static_cast<int>(std::unique(tmp.begin(), tmp.end()) - tmp.begin());
 
 	double curvature = route_length / route_length_straight;
 
 	return { bus_name, stops_count, unic_stops, route_length, curvature };
 }
 
-const std::set<std::string_view>& TransportCatalogue::GetBusesAtStop(const std::string& name) const {
-	if (buses_at_stop_.count(name) == 0) {
-		throw std::out_of_range("Stop " + name + ": not found");
+BusesRange TransportCatalogue::GetBusesAtStop(std::string_view name) const {
+	return GetBusesAtStop(GetStopId(name));
+}
+
+std::optional<BusesRange> TransportCatalogue::FindBusesAtStop(std::string_view name) const {
+	if (const auto id = FindStopId(name)) {
+		return GetBusesAtStop(*id);
 	}
-	return buses_at_stop_.at(name);
+	return std::nullopt;
+}
 
+void TransportCatalogue::SetDistance(std::string_view from, std::string_view to, int distance) {
+	SetDistance(GetStopId(from), GetStopId(to), distance);
 }
 
-void TransportCatalogue::SetDistance(const std::string& from, const std::string& to, int distance) {
-	distances_[{ &GetStop(from), &GetStop(to) }] = distance;
+void TransportCatalogue::SetDistance(domain::StopId from, domain::StopId to, int distance) {
+	distances_[{ from, to }] = distance;
 }
 
-int TransportCatalogue::GetDistance(const std::string& from, const std::string& to) const {
-	if (distances_.count({ &GetStop(from), &GetStop(to) })) {
-		return distances_.at({ &GetStop(from), &GetStop(to) });
-	} else if (distances_.count({ &GetStop(to), &GetStop(from) })) {
-		return distances_.at({ &GetStop(to), &GetStop(from) });
+int TransportCatalogue::GetDistance(domain::StopId from, domain::StopId to) const {
+	if (!road_distances_.offsets.empty()) {
+		const auto begin = road_distances_.neighbors.begin() + road_distances_.offsets[from];
+		const auto end = road_distances_.neighbors.begin() + road_distances_.offsets[from + 1];
+		const auto it = std::lower_bound(begin, end, to);
+		if (it != end && *it == to) {
+			return road_distances_.distances[it - road_distances_.neighbors.begin()];
+		}
+		throw std::out_of_range("no distance between " + std::string(stop_names_[to]) + " and " + std::string(stop_names_[from]));
+	}
+
+	if (distances_.count({ from, to })) {
+		return distances_.at({ from, to });
+	} else if (distances_.count({ to, from })) {
+		return distances_.at({ to, from });
 	} else {
-		throw std::out_of_range("no distance between " + to + " and " + from);
+		throw std::out_of_range("no distance between " + std::string(stop_names_[to]) + " and " + std::string(stop_names_[from]));
 	}
 
 	return 0;
 }
 
-const std::unordered_map<std::pair<const domain::Stop*, const domain::Stop*>,
-	int, DistancesHash>& TransportCatalogue::GetAllDistances() const {
-	return distances_;
+domain::StopId TransportCatalogue::GetStopId(std::string_view name) const {
+	if (const auto id = FindStopId(name)) {
+		return *id;
+	}
+	throw std::out_of_range("Stop " + std::string(name) + ": not found");
+}
+
+domain::BusId TransportCatalogue::GetBusId(std::string_view name) const {
+	if (const auto id = FindBusId(name)) {
+		return *id;
+	}
+	throw std::out_of_range("Bus " + std::string(name) + ": not found");
+}
+
+std::optional<domain::StopId> TransportCatalogue::FindStopId(std::string_view name) const {
+	if (!stop_index_.IsEmpty()) {
+		const auto id = stop_index_(name);
+		if (stop_names_[id] == name) {
+			return id;
+		}
+	} else if (const auto it = stop_id_by_name_.find(name); it != stop_id_by_name_.end()) {
+		return it->second;
+	}
+	return std::nullopt;
+}
+
+std::optional<domain::BusId> TransportCatalogue::FindBusId(std::string_view name) const {
+	if (!bus_index_.IsEmpty()) {
+		const auto id = bus_index_(name);
+		if (bus_names_[id] == name) {
+			return id;
+		}
+	} else if (const auto it = bus_id_by_name_.find(name); it != bus_id_by_name_.end()) {
+		return it->second;
+	}
+	return std::nullopt;
+}
+
+size_t TransportCatalogue::GetStopCount() const {
+	return stop_names_.size();
+}
+
+size_t TransportCatalogue::GetBusCount() const {
+	return buses_.size();
+}
+
+std::string_view TransportCatalogue::GetStopName(domain::StopId id) const {
+	return stop_names_[id];
+}
+
+geo::StoredCoordinates TransportCatalogue::GetStopCoordinates(domain::StopId id) const {
+	return stop_coordinates_[id];
+}
+
+BusesRange TransportCatalogue::GetBusesAtStop(domain::StopId id) const {
+	return { stop_buses_.begin() + stop_buses_offsets_[id], stop_buses_.begin() + stop_buses_offsets_[id + 1] };
+}
+
+std::string_view TransportCatalogue::GetBusName(domain::BusId id) const {
+	return bus_names_[id];
+}
+
+const domain::Bus& TransportCatalogue::GetBus(domain::BusId id) const {
+	return buses_[id];
+}
+
+RouteRange TransportCatalogue::GetRoute(domain::BusId id) const {
+	const auto* begin = route_pool_.data() + buses_[id].route_offset;
+	return { begin, begin + buses_[id].route_size };
+}
+
+RouteDistancesRange TransportCatalogue::GetForwardDistances(domain::BusId id) const {
+	const auto* begin = forward_distances_pool_.data() + buses_[id].route_offset;
+	return { begin, begin + buses_[id].route_size };
 }
 
-const std::unordered_map<std::string_view, const domain::Bus*>& TransportCatalogue::GetAllBuses() const {
-	return name_to_bus_;
+RouteDistancesRange TransportCatalogue::GetBackwardDistances(domain::BusId id) const {
+	const auto* begin = backward_distances_pool_.data() + buses_[id].route_offset;
+	return { begin, begin + buses_[id].route_size };
 }
 
-const std::unordered_map<std::string_view, const domain::Stop*>& TransportCatalogue::GetAllStops() const {
-	return name_to_stop_;
+const std::vector<domain::StopId>& TransportCatalogue::GetRoutePool() const {
+	return route_pool_;
 }
 
-const domain::Stop& TransportCatalogue::GetStop(const std::string& name) const {
-	if (name_to_stop_.count(name) == 0) {
-		throw std::out_of_range("Stop " + name + ": not found");
+void TransportCatalogue::FillRouteDistances(const domain::Bus& bus) {
+	const auto* route = route_pool_.data() + bus.route_offset;
+	auto* forward = forward_distances_pool_.data() + bus.route_offset;
+	auto* backward = backward_distances_pool_.data() + bus.route_offset;
+
+	for (size_t i = 1; i < bus.route_size; ++i) {
+		forward[i] = forward[i - 1] + GetDistance(route[i - 1], route[i]);
+		if (!bus.ring_route) {
+			backward[i] = backward[i - 1] + GetDistance(route[i], route[i - 1]);
+		}
+	}
+}
+
+const RoadDistances& TransportCatalogue::GetRoadDistances() const {
+	return road_distances_;
+}
+
+void TransportCatalogue::SetRoadDistances(RoadDistances distances) {
+	road_distances_ = std::move(distances);
+}
+
+void TransportCatalogue::BuildRoadDistances() {
+	struct Entry {
+		domain::StopId from;
+		domain::StopId to;
+		int distance;
+	};
+	std::vector<Entry> entries;
+	entries.reserve(2 * distances_.size());
+
+	// a distance set in one direction only is used for both of them
+	for (const auto& [stops, distance] : distances_) {
+		entries.push_back({ stops.first, stops.second, distance });
+		if (distances_.count({ stops.second, stops.first }) == 0) {
+			entries.push_back({ stops.second, stops.first, distance });
+		}
+	}
+	std::sort(entries.begin(), entries.end(), [](const Entry& lhs, const Entry& rhs) {
+		return std::pair{ lhs.from, lhs.to } < std::pair{ rhs.from, rhs.to };
+	});
+
+	road_distances_.offsets.assign(stop_names_.size() + 1, 0);
+	road_distances_.neighbors.clear();
+	road_distances_.distances.clear();
+	road_distances_.neighbors.reserve(entries.size());
+	road_distances_.distances.reserve(entries.size());
+
+	for (const auto& entry : entries) {
+		++road_distances_.offsets[entry.from + 1];
+		road_distances_.neighbors.push_back(entry.to);
+		road_distances_.distances.push_back(entry.distance);
 	}
-	return *name_to_stop_.at(name);
+	std::partial_sum(road_distances_.offsets.begin(), road_distances_.offsets.end(), road_distances_.offsets.begin());
+
+	distances_ = {};
+}
+
+const perfect_hash::PerfectHash& TransportCatalogue::GetStopIndex() const {
+	return stop_index_;
+}
+
+const perfect_hash::PerfectHash& TransportCatalogue::GetBusIndex() const {
+	return bus_index_;
+}
+
+void TransportCatalogue::SetNameIndexes(perfect_hash::PerfectHash stop_index, perfect_hash::PerfectHash bus_index) {
+	stop_index_ = std::move(stop_index);
+	bus_index_ = std::move(bus_index);
+}
+
+const std::vector<domain::BusStat>& TransportCatalogue::GetBusStats() const {
+	return bus_stats_;
+}
+
+void TransportCatalogue::SetBusStats(std::vector<domain::BusStat> stats) {
+	bus_stats_ = std::move(stats);
+}
+
+const std::vector<uint32_t>& TransportCatalogue::GetStopBusesOffsets() const {
+	return stop_buses_offsets_;
+}
+
+const std::vector<domain::BusId>& TransportCatalogue::GetStopBuses() const {
+	return stop_buses_;
+}
+
+void TransportCatalogue::SetStopBuses(std::vector<uint32_t> offsets, std::vector<domain::BusId> stop_buses) {
+	stop_buses_offsets_ = std::move(offsets);
+	stop_buses_ = std::move(stop_buses);
 }
 
-const domain::Bus& TransportCatalogue::GetBus(const std::string& name) const {
-	if (name_to_bus_.count(name) == 0) {
-		throw std::out_of_range("Bus " + name + ": not found");
+std::vector<spatial_index::Neighbor> TransportCatalogue::FindNearbyStops(geo::Coordinates center, double radius, size_t count) const {
+	return stop_grid_.FindNearest(stop_coordinates_, center, count, radius);
+}
+
+const spatial_index::SpatialIndex& TransportCatalogue::GetStopGrid() const {
+	return stop_grid_;
+}
+
+void TransportCatalogue::SetStopGrid(spatial_index::SpatialIndex grid) {
+	stop_grid_ = std::move(grid);
+}
+
+const std::vector<domain::BusId>& TransportCatalogue::GetBusesByName() const {
+	return buses_by_name_;
+}
+
+const std::vector<domain::StopId>& TransportCatalogue::GetStopsByName() const {
+	return stops_by_name_;
+}
+
+const std::vector<domain::StopId>& TransportCatalogue::GetServedStopsByName() const {
+	return served_stops_by_name_;
+}
+
+void TransportCatalogue::SetNameOrders(std::vector<domain::BusId> buses, std::vector<domain::StopId> stops,
+	std::vector<domain::StopId> served_stops) {
+	buses_by_name_ = std::move(buses);
+	stops_by_name_ = std::move(stops);
+	served_stops_by_name_ = std::move(served_stops);
+}
+
+memory_usage::Report TransportCatalogue::GetMemoryUsage() const {
+	using namespace memory_usage;
+	Report res;
+
+	res["stops"] = GetVectorBytes(stop_names_) + GetVectorBytes(stop_coordinates_);
+	res["buses"] = GetVectorBytes(bus_names_) + GetVectorBytes(buses_) + GetVectorBytes(bus_stats_);
+	res["routes"] = GetVectorBytes(route_pool_) + GetVectorBytes(forward_distances_pool_) + GetVectorBytes(backward_distances_pool_);
+	res["names"] = names_.GetCapacity();
+	res["name_indexes"] = GetVectorBytes(stop_index_.GetDisplacements()) + GetVectorBytes(stop_index_.GetValues())
+		+ GetVectorBytes(bus_index_.GetDisplacements()) + GetVectorBytes(bus_index_.GetValues())
+		+ GetHashTableBytes(stop_id_by_name_) + GetHashTableBytes(bus_id_by_name_);
+	res["distances"] = GetHashTableBytes(distances_) + GetVectorBytes(road_distances_.offsets)
+		+ GetVectorBytes(road_distances_.neighbors) + GetVectorBytes(road_distances_.distances);
+	res["buses_at_stop"] = GetVectorBytes(stop_buses_offsets_) + GetVectorBytes(stop_buses_);
+	res["stop_grid"] = GetVectorBytes(stop_grid_.GetGrid().offsets) + GetVectorBytes(stop_grid_.GetGrid().points);
+	res["name_orders"] = GetVectorBytes(buses_by_name_) + GetVectorBytes(stops_by_name_) + GetVectorBytes(served_stops_by_name_);
+
+	return res;
+}
+
+void TransportCatalogue::BuildNameOrders() {
+	buses_by_name_.resize(buses_.size());
+	std::iota(buses_by_name_.begin(), buses_by_name_.end(), domain::BusId{ 0 });
+	std::sort(buses_by_name_.begin(), buses_by_name_.end(), [this](domain::BusId lhs, domain::BusId rhs) {
+		return bus_names_[lhs] < bus_names_[rhs];
+	});
+
+	stops_by_name_.resize(stop_names_.size());
+	std::iota(stops_by_name_.begin(), stops_by_name_.end(), domain::StopId{ 0 });
+	std::sort(stops_by_name_.begin(), stops_by_name_.end(), [this](domain::StopId lhs, domain::StopId rhs) {
+		return stop_names_[lhs] < stop_names_[rhs];
+	});
+}
+
+void TransportCatalogue::BuildServedStops() {
+	served_stops_by_name_.clear();
+	for (const auto stop : stops_by_name_) {
+		if (stop_buses_offsets_[stop] != stop_buses_offsets_[stop + 1]) {
+			served_stops_by_name_.push_back(stop);
+		}
+	}
+}
+
+void TransportCatalogue::BuildStopBuses() {
+	// buses are appended in name order, so every row gets sorted by name. A name is looked up
+	// to the bus added last with it, earlier buses of the same name are left out
+	std::vector<domain::BusId> buses;
+	buses.reserve(buses_by_name_.size());
+	for (size_t i = 0; i < buses_by_name_.size(); ++i) {
+		domain::BusId last_added = buses_by_name_[i];
+		while (i + 1 < buses_by_name_.size() && bus_names_[buses_by_name_[i + 1]] == bus_names_[last_added]) {
+			last_added = std::max(last_added, buses_by_name_[++i]);
+		}
+		buses.push_back(last_added);
+	}
+
+	// a bus visiting a stop several times is counted once
+	constexpr auto NO_BUS = static_cast<domain::BusId>(-1);
+	std::vector<domain::BusId> last_bus(stop_names_.size(), NO_BUS);
+
+	stop_buses_offsets_.assign(stop_names_.size() + 1, 0);
+	for (const auto bus : buses) {
+		for (const auto stop : GetRoute(bus)) {
+			if (last_bus[stop] != bus) {
+				last_bus[stop] = bus;
+				++stop_buses_offsets_[stop + 1];
+			}
+		}
+	}
+	std::partial_sum(stop_buses_offsets_.begin(), stop_buses_offsets_.end(), stop_buses_offsets_.begin());
+
+	std::vector<uint32_t> positions(stop_buses_offsets_.begin(), stop_buses_offsets_.end() - 1);
+	std::fill(last_bus.begin(), last_bus.end(), NO_BUS);
+	stop_buses_.resize(stop_buses_offsets_.back());
+	for (const auto bus : buses) {
+		for (const auto stop : GetRoute(bus)) {
+			if (last_bus[stop] != bus) {
+				last_bus[stop] = bus;
+				stop_buses_[positions[stop]++] = bus;
+			}
+		}
 	}
-	return *name_to_bus_.at(name);
 }
 
 } // transport_catalogue
\ No newline at end of file
@@ -1,58 +1,218 @@
 #pragma once
 
+#include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <set>
 #include <unordered_map>
-#include <deque>
 
 #include "domain.h"
+#include "ranges.h"
+#include "perfect_hash.h"
+#include "string_arena.h"
+#include "spatial_index.h"
+#include "memory_usage.h"
 
 namespace transport_catalogue {
 
 struct DistancesHash {
-	std::hash<const void*> hasher;
-
-	size_t operator()(const std::pair<const domain::Stop*, const domain::Stop*> dist) const {
-		return hasher(dist.first) * 37 + hasher(dist.second);
+	size_t operator()(const std::pair<domain::StopId, domain::StopId> dist) const {
+		// both ids packed into one word and mixed, so pairs of close ids don't collide
+		uint64_t hash = (static_cast<uint64_t>(dist.first) << 32) | dist.second;
+		hash = (hash ^ (hash >> 33)) * 0xFF51AFD7ED558CCDULL;
+		return static_cast<size_t>(hash ^ (hash >> 33));
 	}
 };
 
+using Distances = std::unordered_map<std::pair<domain::StopId, domain::StopId>, int, DistancesHash>;
+
+// road distances from stop i to stops neighbors[offsets[i]] .. neighbors[offsets[i + 1] - 1],
+// every row is sorted by neighbor id
+struct RoadDistances {
+	std::vector<uint32_t> offsets;
+	std::vector<domain::StopId> neighbors;
+	std::vector<int> distances;
+};
+
+// amounts of data about to be loaded, see TransportCatalogue::Reserve()
+struct CatalogueSizes {
+	size_t stops = 0;
+	size_t buses = 0;
+	// stops of all routes together
+	size_t route_stops = 0;
+	// names of all stops and buses together
+	size_t name_bytes = 0;
+};
+
+using BusesRange = ranges::Range<std::vector<domain::BusId>::const_iterator>;
+using RouteRange = ranges::Range<const domain::StopId*>;
+using RouteDistancesRange = ranges::Range<const int*>;
+
 class TransportCatalogue {
 public:
 	TransportCatalogue() = default;
 
-	void AddStop(const std::string& name, geo::Coordinates coordinates);
+	// allocates storage for the data about to be loaded, so bulk loading doesn't reallocate
+	void Reserve(const CatalogueSizes& sizes);
 
-	void AddBus(const std::string& name, const std::vector<std::string>& stops, bool ring_route);
+	// builds lookup structures over the loaded data, stops and buses mustn't be added afterwards
+	void Freeze();
 
-	const domain::BusStat GetBusInfo(const std::string& name) const;
+	domain::StopId AddStop(std::string_view name, geo::Coordinates coordinates);
 
-	const std::set<std::string_view>& GetBusesAtStop(const std::string& name) const;
+	domain::BusId AddBus(std::string_view name, const std::vector<std::string_view>& stops, bool ring_route);
 
-	void SetDistance(const std::string& from, const std::string& to, int distance);
+	domain::BusId AddBus(std::string_view name, RouteRange stops, bool ring_route);
 
-	int GetDistance(const std::string& from, const std::string& to) const;
+	// throw std::out_of_range for unknown names
+	const domain::BusStat GetBusInfo(std::string_view name) const;
 
-	const std::unordered_map<std::string_view, const domain::Bus*>& GetAllBuses() const;
+	BusesRange GetBusesAtStop(std::string_view name) const;
 
-	const std::unordered_map<std::string_view, const domain::Stop*>& GetAllStops() const;
+	// nullopt for unknown names, nothing is thrown
+	std::optional<domain::BusStat> FindBusStat(std::string_view name) const;
 
-	const std::unordered_map<std::pair<const domain::Stop*, const domain::Stop*>,
-		int, DistancesHash>& GetAllDistances() const;
-	
-private:
-	std::deque<domain::Stop> stops_;
-	std::deque<domain::Bus> buses_;
+	std::optional<BusesRange> FindBusesAtStop(std::string_view name) const;
+
+	void SetDistance(std::string_view from, std::string_view to, int distance);
+
+	void SetDistance(domain::StopId from, domain::StopId to, int distance);
+
+	int GetDistance(domain::StopId from, domain::StopId to) const;
+
+	domain::StopId GetStopId(std::string_view name) const;
+
+	domain::BusId GetBusId(std::string_view name) const;
+
+	std::optional<domain::StopId> FindStopId(std::string_view name) const;
+
+	std::optional<domain::BusId> FindBusId(std::string_view name) const;
+
+	size_t GetStopCount() const;
+
+	size_t GetBusCount() const;
+
+	std::string_view GetStopName(domain::StopId id) const;
+
+	geo::StoredCoordinates GetStopCoordinates(domain::StopId id) const;
+
+	// buses passing the stop, ordered by name, of buses sharing a name only the one added last
+	BusesRange GetBusesAtStop(domain::StopId id) const;
+
+	std::string_view GetBusName(domain::BusId id) const;
+
+	const domain::Bus& GetBus(domain::BusId id) const;
 
-	std::unordered_map<std::string_view, const domain::Stop*> name_to_stop_;
-	std::unordered_map<std::string_view, const domain::Bus*> name_to_bus_;
-	std::unordered_map<std::string_view, std::set<std::string_view>> buses_at_stop_;
-	std::unordered_map<std::pair<const domain::Stop*, const domain::Stop*>, int, DistancesHash> distances_;
+	RouteRange GetRoute(domain::BusId id) const;
 
-	const domain::Stop& GetStop(const std::string& name) const;
+	// cumulative road distances from the first stop of the route to the i-th one,
+	// known once the catalogue is frozen or restored
+	RouteDistancesRange GetForwardDistances(domain::BusId id) const;
 
-	const domain::Bus& GetBus(const std::string& name) const;
+	// cumulative road distances back from the i-th stop of the route to the first one,
+	// only for not ring routes
+	RouteDistancesRange GetBackwardDistances(domain::BusId id) const;
+
+	// routes of all buses one after another
+	const std::vector<domain::StopId>& GetRoutePool() const;
+
+	const RoadDistances& GetRoadDistances() const;
+
+	// restores road distances built by Freeze(), must be called before buses are added
+	void SetRoadDistances(RoadDistances distances);
+
+	const perfect_hash::PerfectHash& GetStopIndex() const;
+
+	const perfect_hash::PerfectHash& GetBusIndex() const;
+
+	// restores name indexes built by Freeze(), must be called before stops and buses are added
+	void SetNameIndexes(perfect_hash::PerfectHash stop_index, perfect_hash::PerfectHash bus_index);
+
+	const std::vector<domain::BusStat>& GetBusStats() const;
+
+	// restores statistics computed by Freeze(), indexed by bus id
+	void SetBusStats(std::vector<domain::BusStat> stats);
+
+	// buses of stop i are stop_buses[offsets[i]] .. stop_buses[offsets[i + 1] - 1]
+	const std::vector<uint32_t>& GetStopBusesOffsets() const;
+
+	const std::vector<domain::BusId>& GetStopBuses() const;
+
+	// restores the stop to buses index built by Freeze()
+	void SetStopBuses(std::vector<uint32_t> offsets, std::vector<domain::BusId> stop_buses);
+
+	// ids ordered by name
+	const std::vector<domain::BusId>& GetBusesByName() const;
+
+	const std::vector<domain::StopId>& GetStopsByName() const;
+
+	// stops with at least one bus, ordered by name
+	const std::vector<domain::StopId>& GetServedStopsByName() const;
+
+	// restores the orders built by Freeze()
+	void SetNameOrders(std::vector<domain::BusId> buses, std::vector<domain::StopId> stops,
+		std::vector<domain::StopId> served_stops);
+
+	memory_usage::Report GetMemoryUsage() const;
+
+	// at most count stops nearest to center, not farther than radius meters, nearest first
+	std::vector<spatial_index::Neighbor> FindNearbyStops(geo::Coordinates center, double radius, size_t count) const;
+
+	const spatial_index::SpatialIndex& GetStopGrid() const;
+
+	// restores the spatial index of stops built by Freeze()
+	void SetStopGrid(spatial_index::SpatialIndex grid);
+
+private:
+	// all names are kept in the arena
+	string_arena::StringArena names_;
+
+	// stops and buses are stored by columns, all indexed by id
+	std::vector<std::string_view> stop_names_;
+	std::vector<geo::StoredCoordinates> stop_coordinates_;
+	// compressed sparse rows of buses passing every stop
+	std::vector<uint32_t> stop_buses_offsets_;
+	std::vector<domain::BusId> stop_buses_;
+	spatial_index::SpatialIndex stop_grid_;
+	std::vector<domain::StopId> stops_by_name_;
+	std::vector<domain::StopId> served_stops_by_name_;
+
+	std::vector<std::string_view> bus_names_;
+	std::vector<domain::Bus> buses_;
+	// routes and their cumulative distances packed one after another, see domain::Bus
+	std::vector<domain::StopId> route_pool_;
+	std::vector<int> forward_distances_pool_;
+	std::vector<int> backward_distances_pool_;
+	std::vector<domain::BusStat> bus_stats_;
+	std::vector<domain::BusId> buses_by_name_;
+
+	// names are looked up with hash tables while the catalogue is being filled
+	// and with perfect hash functions once it's frozen
+	std::unordered_map<std::string_view, domain::StopId> stop_id_by_name_;
+	std::unordered_map<std::string_view, domain::BusId> bus_id_by_name_;
+	perfect_hash::PerfectHash stop_index_;
+	perfect_hash::PerfectHash bus_index_;
+
+	// distances set while the catalogue is being filled are gathered in a hash table,
+	// Freeze() moves them into adjacency arrays with both directions resolved
+	Distances distances_;
+	RoadDistances road_distances_;
+
+	// adds the bus whose route is the tail of the route pool starting at route_offset
+	domain::BusId AddBusRoute(std::string_view name, size_t route_offset, bool ring_route);
+
+	void FillRouteDistances(const domain::Bus& bus);
+
+	void BuildRoadDistances();
+
+	// distances is a buffer reused between calls
+	domain::BusStat ComputeBusStat(domain::BusId id, const geo::SpherePoints& points, std::vector<double>& distances) const;
+
+	void BuildNameOrders();
+
+	void BuildStopBuses();
+
+	void BuildServedStops();
 };
 
 } // namespace transport_catalogue
\ No newline at end of file
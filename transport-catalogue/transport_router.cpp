@@ -1,26 +1,38 @@
+#include <algorithm>
+
 #include "transport_router.h"
+#include "parallel.h"
 
 namespace transport_router {
 
-std::optional<TransportRoute> TransportRouter::BuildRoute(const std::string& from, const std::string& to) const {
+std::optional<TransportRoute> TransportRouter::BuildRoute(domain::StopId from, domain::StopId to) const {
+	TransportRoute res;
+	if (!BuildRoute(from, to, res)) {
+		return std::nullopt;
+	}
+	return res;
+}
+
+bool TransportRouter::BuildRoute(domain::StopId from, domain::StopId to, TransportRoute& route) const {
+	route.total_time = 0.0;
+	route.route.clear();
 	if (from == to) {
-		return TransportRoute{};
+		return true;
 	}
-	
-	const auto route = router_->BuildRoute(stop_id_by_name_.at(from), stop_id_by_name_.at(to));
-		
-	if (!route.has_value()) {
-		return std::nullopt;
+	if (!router_ || from >= graph_.GetVertexCount() || to >= graph_.GetVertexCount()) {
+		return false;
 	}
-	TransportRoute res;
-	res.total_time = route->weight.total_time;
 
-	for (const auto& id : route->edges) {
-		const auto& edge = graph_.GetEdge(id);		
-		res.route.push_back(edge.weight);
+	const auto weight = router_->WalkRouteBackward(from, to, [this, &route](graph::EdgeId id) {
+		route.route.push_back(graph_.GetEdge(id).weight);
+	});
+	if (!weight.has_value()) {
+		return false;
 	}
+	std::reverse(route.route.begin(), route.route.end());
+	route.total_time = weight->total_time;
 
-	return res;
+	return true;
 }
 
 void TransportRouter::InitializeRouterWithCatalogue(const transport_catalogue::TransportCatalogue& catalogue) {
@@ -30,52 +42,70 @@ void TransportRouter::InitializeRouterWithCatalogue(const transport_catalogue::T
 }
 
 void TransportRouter::BuildGraphBasedOnCatalogue(const transport_catalogue::TransportCatalogue& catalogue) {
-	graph::DirectedWeightedGraph<EdgeWeight> graph(catalogue.GetAllStops().size());
+	// vertex ids are stop ids of the catalogue
+	graph::DirectedWeightedGraph<EdgeWeight> graph(catalogue.GetStopCount());
 	graph_ = std::move(graph);
 
-	for (const auto& [name, bus] : catalogue.GetAllBuses()) {
-		int stops_cnt = static_cast<int>(bus->route.size());
-		for (int from = 0; from < stops_cnt; ++from) {
-			double route_time_forward = settings_.bus_wait_time;
-			double route_time_backward = settings_.bus_wait_time;
-			for (int to = from + 1; to < stops_cnt; ++to) {
-				route_time_forward += catalogue.GetDistance(bus->route[to-1]->name, bus->route[to]->name) / settings_.bus_velocity;
-				BuildEdge(EdgeWeight{
-					name,
-					bus->route[from]->name,
-					bus->route[to]->name,
-					route_time_forward,
-					to - from
-					});
-
-				if (!bus->ring_route) {
-					route_time_backward += catalogue.GetDistance(bus->route[to]->name, bus->route[to-1]->name) / settings_.bus_velocity;
-					BuildEdge(EdgeWeight{
-						name,
-						bus->route[to]->name,
-						bus->route[from]->name,
-						route_time_backward,
-						to - from
-						});
-				}
-			}
+	const size_t bus_count = catalogue.GetBusCount();
+	const size_t chunk_count = parallel::GetChunkCount(bus_count);
+	std::vector<std::vector<graph::Edge<EdgeWeight>>> chunk_edges(chunk_count);
+
+	parallel::ForEachChunk(bus_count, chunk_count, [&](size_t chunk, size_t begin, size_t end) {
+		for (size_t id = begin; id < end; ++id) {
+			BuildBusEdges(catalogue, static_cast<domain::BusId>(id), chunk_edges[chunk]);
 		}
-	}
-}
+	});
 
-void TransportRouter::BuildEdge(EdgeWeight edge) {
-	auto id_from = AssignStopId(edge.from);
-	auto id_to = AssignStopId(edge.to);
+	size_t edge_count = 0;
+	for (const auto& edges : chunk_edges) {
+		edge_count += edges.size();
+	}
+	graph_.GetEdges().reserve(edge_count);
 
-	graph_.AddEdge(graph::Edge<EdgeWeight>{id_from, id_to, std::move(edge)});
+	for (const auto& edges : chunk_edges) {
+		for (const auto& edge : edges) {
+			graph_.AddEdge(edge);
+		}
+	}
 }
 
-graph::VertexId TransportRouter::AssignStopId(std::string_view stop) {
-	auto stop_id = stop_id_by_name_.size();
-	if (!stop_id_by_name_.count(stop)) {
-		stop_id_by_name_[stop] = stop_id;
+void TransportRouter::BuildBusEdges(const transport_catalogue::TransportCatalogue& catalogue, domain::BusId id,
+	std::vector<graph::Edge<EdgeWeight>>& edges) const {
+	const auto& bus = catalogue.GetBus(id);
+	const auto route = catalogue.GetRoute(id);
+	const auto forward_distances = catalogue.GetForwardDistances(id);
+	const auto backward_distances = catalogue.GetBackwardDistances(id);
+
+	int stops_cnt = static_cast<int>(route.size());
+	for (int from = 0; from < stops_cnt; ++from) {
+		for (int to = from + 1; to < stops_cnt; ++to) {
+			double route_time_forward = settings_.bus_wait_time
+				+ (forward_distances[to] - forward_distances[from]) / settings_.bus_velocity;
+			edges.push_back(MakeEdge(EdgeWeight{
+				id,
+				route[from],
+				route[to],
+				route_time_forward,
+				to - from
+				}));
+
+			if (!bus.ring_route) {
+				double route_time_backward = settings_.bus_wait_time
+					+ (backward_distances[to] - backward_distances[from]) / settings_.bus_velocity;
+				edges.push_back(MakeEdge(EdgeWeight{
+					id,
+					route[to],
+					route[from],
+					route_time_backward,
+					to - from
+					}));
+			}
+		}
 	}
-	return stop_id_by_name_.at(stop);
+}
+
+graph::Edge<EdgeWeight> TransportRouter::MakeEdge(EdgeWeight edge) {
+	return graph::Edge<EdgeWeight>{edge.from, edge.to, std::move(edge)};
 }
 
 EdgeWeight operator+(const EdgeWeight& lhs, const EdgeWeight& rhs) {
@@ -92,6 +122,29 @@ bool operator>(const EdgeWeight& lhs, const EdgeWeight& rhs) {
 	return rhs < lhs;
 }
 
+memory_usage::Report TransportRouter::GetMemoryUsage() const {
+	using namespace memory_usage;
+	Report res;
+
+	res["graph_edges"] = GetVectorBytes(graph_.GetEdges());
+	size_t incidence_lists = GetVectorBytes(graph_.GetIncidenceLists());
+	for (const auto& list : graph_.GetIncidenceLists()) {
+		incidence_lists += GetVectorBytes(list);
+	}
+	res["graph_incidence_lists"] = incidence_lists;
+
+	size_t router = 0;
+	if (router_) {
+		router = GetVectorBytes(router_->GetRoutesInternalData());
+		for (const auto& row : router_->GetRoutesInternalData()) {
+			router += GetVectorBytes(row);
+		}
+	}
+	res["router"] = router;
+
+	return res;
+}
+
 void TransportRouter::SetRouterSettings(RouterSettings settings) {
 	settings_ = settings;
 }
@@ -108,9 +161,4 @@ std::unique_ptr<TransportRouter::Router>& TransportRouter::GetRouter() {
 	return router_;
 }
 
-std::unordered_map<std::string_view, graph::VertexId>& TransportRouter::GetStopsIdByName() {
-	return stop_id_by_name_;
-}
-
-
 } // namespace transport_router
\ No newline at end of file
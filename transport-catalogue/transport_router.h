@@ -3,12 +3,12 @@
 #include "transport_catalogue.h"
 #include "graph.h"
 #include "router.h"
+#include "memory_usage.h"
 
 #include <string>
 #include <optional>
 #include <memory>
 #include <vector>
-#include <unordered_map>
 
 namespace transport_router {
 
@@ -18,10 +18,10 @@ struct RouterSettings {
 };
 
 struct EdgeWeight {
-	std::string_view bus_name;
-	std::string_view from;
-	std::string_view to;
-	double total_time;
+	domain::BusId bus = 0;
+	domain::StopId from = 0;
+	domain::StopId to = 0;
+	double total_time = 0.0;
 	int span_count = 0;
 };
 
@@ -44,7 +44,12 @@ public:
 
 	void InitializeRouterWithCatalogue(const transport_catalogue::TransportCatalogue& catalogue);
 
-	std::optional<TransportRoute> BuildRoute(const std::string &from, const std::string &to) const;
+	// nullopt if there's no route or the router isn't built for these stops
+	std::optional<TransportRoute> BuildRoute(domain::StopId from, domain::StopId to) const;
+
+	// same as above, the route is written to a buffer the caller may reuse between calls,
+	// nothing is allocated once the buffer is big enough
+	bool BuildRoute(domain::StopId from, domain::StopId to, TransportRoute& route) const;
 	
 	void SetRouterSettings(RouterSettings settings);
 
@@ -54,7 +59,7 @@ public:
 
 	std::unique_ptr<Router>& GetRouter();
 
-	std::unordered_map<std::string_view, graph::VertexId>& GetStopsIdByName();
+	memory_usage::Report GetMemoryUsage() const;
 
 private:
 	RouterSettings settings_ = {};
@@ -62,13 +67,12 @@ private:
 	Graph graph_;
 	std::unique_ptr<Router> router_;
 
-	std::unordered_map<std::string_view, graph::VertexId> stop_id_by_name_;
-
 	void BuildGraphBasedOnCatalogue(const transport_catalogue::TransportCatalogue& catalogue);
 
-	void BuildEdge(EdgeWeight edge);
+	void BuildBusEdges(const transport_catalogue::TransportCatalogue& catalogue, domain::BusId id,
+		std::vector<graph::Edge<EdgeWeight>>& edges) const;
 
-	graph::VertexId AssignStopId(std::string_view stop);
+	static graph::Edge<EdgeWeight> MakeEdge(EdgeWeight edge);
 };
 
 } // namespace transport_router
\ No newline at end of file